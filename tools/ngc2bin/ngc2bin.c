@@ -0,0 +1,754 @@
+/*
+	Name: ngc2bin.c
+	Description: Host side compiler of RS274NGC files (.ngc) to the uCNC binary gcode format.
+		Each gcode line is encoded in a binary frame (see uCNC/binary_gcode.h).
+		Modal words that do not change the parser state (repeated motion modes and feeds)
+		are removed from the output. The motion word is sent in the frame opcode and the
+		line number and axis words are sent as the difference from the previous value.
+		Lines that can't be encoded (Grbl '$' commands, lines too long or values with more than
+		4 decimal places) are copied as ASCII.
+
+	Copyright: Copyright (c) João Martins
+	Author: João Martins
+	Date: 19/10/2026
+
+	uCNC is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version. Please see <http://www.gnu.org/licenses/>
+
+	uCNC is distributed WITHOUT ANY WARRANTY;
+	Also without the implied warranty of	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+	See the	GNU General Public License for more details.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <ctype.h>
+#include "../../uCNC/binary_gcode.h"
+
+#define LINE_MAX_LEN 256
+#define MAX_WORDS 32
+
+typedef struct
+{
+	char letter;
+	int64_t mantissa; //value without decimal point
+	uint8_t decimals; //number of decimal places
+	double value;
+} ngc_word_t;
+
+//modal state tracked to remove redundant words (-1 is unknown)
+//starts in the parser state after a reset (G1 and G94)
+static int motion_mode = 1;
+static int feed_mode = 94;
+static double feed = -1;
+//last value of the delta coded words (same as the controller)
+static const char delta_words[BINARY_GCODE_DELTA_WORDS] = {'X', 'Y', 'Z', 'A', 'B', 'C', 'N'};
+static int64_t delta_last[BINARY_GCODE_DELTA_WORDS];
+
+static uint8_t crc7(uint8_t c, uint8_t crc)
+{
+	crc ^= (c & 0x80) ? (c ^ 0x89) : c;
+	for (uint8_t i = 7; i != 0; i--)
+	{
+		crc <<= 1;
+		if (crc & 0x80)
+		{
+			crc ^= 0x89;
+		}
+	}
+	return (crc);
+}
+
+//CRC16-CCITT (poly 0x1021) used by the framed streaming mode
+static uint16_t crc16(uint8_t c, uint16_t crc)
+{
+	crc ^= (uint16_t)c << 8;
+	for (uint8_t i = 8; i != 0; i--)
+	{
+		crc = (crc & 0x8000) ? ((crc << 1) ^ 0x1021) : (crc << 1);
+	}
+	return crc;
+}
+
+//writes a binary frame or wraps a block in a transport frame of the framed streaming mode
+static size_t write_block(FILE *out, const uint8_t *data, size_t len, bool framed, uint8_t *seq)
+{
+	if (!framed)
+	{
+		//binary frames are sent with the bytes that match a realtime command escaped (except the opcode)
+		size_t size = len;
+		fputc(data[0], out);
+		for (size_t i = 1; i < len; i++)
+		{
+			if (BINARY_GCODE_IS_REALTIME(data[i]) || data[i] == BINARY_GCODE_ESC)
+			{
+				fputc(BINARY_GCODE_ESC, out);
+				fputc(data[i] ^ BINARY_GCODE_ESC_XOR, out);
+				size++;
+			}
+			else
+			{
+				fputc(data[i], out);
+			}
+		}
+		return size;
+	}
+
+	uint8_t header[3] = {BINARY_GCODE_FRAME_SOH, *seq, (uint8_t)len};
+	uint16_t crc = 0xFFFF;
+	for (size_t i = 1; i < 3; i++)
+	{
+		crc = crc16(header[i], crc);
+	}
+	for (size_t i = 0; i < len; i++)
+	{
+		crc = crc16(data[i], crc);
+	}
+
+	fwrite(header, 1, 3, out);
+	fwrite(data, 1, len, out);
+	fputc(crc >> 8, out);
+	fputc(crc & 0xFF, out);
+	(*seq)++;
+	return len + 5;
+}
+
+//ASCII lines are sent with the line end (or without it inside a transport frame)
+static size_t write_ascii(FILE *out, const char *line, size_t len, bool framed, uint8_t *seq)
+{
+	if (!framed)
+	{
+		fprintf(out, "%s\n", line);
+		return len + 1;
+	}
+
+	return write_block(out, (const uint8_t *)line, len, framed, seq);
+}
+
+static void reset_modal_state()
+{
+	motion_mode = -1;
+	feed = -1;
+}
+
+static void reset_all_modal_state()
+{
+	reset_modal_state();
+	feed_mode = -1;
+}
+
+/*
+	Removes whitespaces and comments and converts the line to uppercase
+	Returns the length of the resulting line
+*/
+static size_t clean_line(const char *in, char *out)
+{
+	size_t len = 0;
+	int comment = 0;
+
+	for (; *in != 0; in++)
+	{
+		char c = *in;
+		if (c == '(')
+		{
+			comment++;
+			continue;
+		}
+
+		if (c == ')')
+		{
+			if (comment)
+			{
+				comment--;
+			}
+			continue;
+		}
+
+		if (c == ';' && !comment)
+		{
+			break;
+		}
+
+		if (comment || isspace((unsigned char)c) || c == '%')
+		{
+			continue;
+		}
+
+		out[len++] = (char)toupper((unsigned char)c);
+	}
+
+	out[len] = 0;
+	return len;
+}
+
+/*
+	Splits the line in words
+	Returns the number of words or -1 if the line is invalid
+*/
+static int tokenize(const char *line, ngc_word_t *words)
+{
+	int count = 0;
+
+	while (*line)
+	{
+		ngc_word_t *w = &words[count];
+		bool negative = false;
+		bool hasdigits = false;
+
+		if (count == MAX_WORDS || *line < 'A' || *line > 'Z')
+		{
+			return -1;
+		}
+
+		w->letter = *line++;
+		w->mantissa = 0;
+		w->decimals = 0;
+
+		if (*line == '-' || *line == '+')
+		{
+			negative = (*line == '-');
+			line++;
+		}
+
+		bool isfloat = false;
+		for (;; line++)
+		{
+			if (*line >= '0' && *line <= '9')
+			{
+				//values with more than 4 decimal places are sent as ASCII anyway
+				if (w->decimals < 9)
+				{
+					w->mantissa = w->mantissa * 10 + (*line - '0');
+					if (isfloat)
+					{
+						w->decimals++;
+					}
+				}
+				hasdigits = true;
+			}
+			else if (*line == '.' && !isfloat)
+			{
+				isfloat = true;
+			}
+			else
+			{
+				break;
+			}
+		}
+
+		if (!hasdigits)
+		{
+			return -1;
+		}
+
+		if (negative)
+		{
+			w->mantissa = -w->mantissa;
+		}
+
+		w->value = (double)w->mantissa;
+		for (uint8_t i = w->decimals; i != 0; i--)
+		{
+			w->value /= 10.0;
+		}
+
+		count++;
+	}
+
+	return count;
+}
+
+static bool fits(int64_t value, int64_t min, int64_t max)
+{
+	return (value >= min && value <= max);
+}
+
+static int64_t scale(const ngc_word_t *w, uint8_t decimals)
+{
+	int64_t value = w->mantissa;
+	for (uint8_t i = w->decimals; i < decimals; i++)
+	{
+		value *= 10;
+	}
+	return value;
+}
+
+//writes a variable length number and returns the number of bytes written
+static size_t encode_number(uint32_t value, uint8_t *out)
+{
+	size_t size = 0;
+
+	while (value > BINARY_GCODE_NUMBER_BITS)
+	{
+		out[size++] = (uint8_t)((value & BINARY_GCODE_NUMBER_BITS) | BINARY_GCODE_NUMBER_MORE);
+		value >>= BINARY_GCODE_NUMBER_SHIFT;
+	}
+
+	out[size++] = (uint8_t)value;
+	return size;
+}
+
+static uint64_t zigzag(int64_t value)
+{
+	return (value < 0) ? (((uint64_t)(-value) << 1) - 1) : ((uint64_t)value << 1);
+}
+
+/*
+	Encodes a word with the header and the value in the smallest scale that holds the exact value
+	Returns the number of bytes written or 0 if the value can't be encoded
+*/
+static size_t encode_word(const ngc_word_t *w, uint8_t *out)
+{
+	uint8_t type;
+	int64_t value;
+
+	switch (w->decimals)
+	{
+	case 0:
+		type = BINARY_GCODE_SCALE_1;
+		value = w->mantissa;
+		break;
+	case 1:
+		type = BINARY_GCODE_SCALE_10;
+		value = w->mantissa;
+		break;
+	case 2:
+	case 3:
+		type = BINARY_GCODE_SCALE_1000;
+		value = scale(w, 3);
+		break;
+	case 4:
+		type = BINARY_GCODE_SCALE_10000;
+		value = w->mantissa;
+		break;
+	default:
+		return 0;
+	}
+
+	if (!fits(value, INT32_MIN, INT32_MAX))
+	{
+		return 0;
+	}
+
+	out[0] = BINARY_GCODE_WORD(type, w->letter);
+	return encode_number((uint32_t)zigzag(value), &out[1]) + 1;
+}
+
+/*
+	Encodes the difference between two values with 4 decimal places in the smallest scale that holds the exact value
+	The scale is sent in the bits 1..0 of the number
+	Returns the number of bytes written or 0 if the value can't be encoded
+*/
+static size_t encode_delta(int64_t delta, uint8_t *out)
+{
+	uint8_t type = BINARY_GCODE_SCALE_10000;
+
+	if (!(delta % 10000))
+	{
+		type = BINARY_GCODE_SCALE_1;
+		delta /= 10000;
+	}
+	else if (!(delta % 1000))
+	{
+		type = BINARY_GCODE_SCALE_10;
+		delta /= 1000;
+	}
+	else if (!(delta % 10))
+	{
+		type = BINARY_GCODE_SCALE_1000;
+		delta /= 10;
+	}
+
+	uint64_t value = (zigzag(delta) << 2) | type;
+	if (value > UINT32_MAX)
+	{
+		return 0;
+	}
+
+	return encode_number((uint32_t)value, out);
+}
+
+static int delta_word_index(char letter)
+{
+	for (int i = 0; i < BINARY_GCODE_DELTA_WORDS; i++)
+	{
+		if (delta_words[i] == letter)
+		{
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+static bool is_gcode(const ngc_word_t *w, int64_t mantissa, uint8_t decimals)
+{
+	return (w->letter == 'G' && scale(w, 1) == mantissa * ((decimals == 0) ? 10 : 1));
+}
+
+/*
+	Removes words that don't change the parser modal state
+	Conservative approach. When in doubt the word is kept and the modal state is reset
+*/
+static int remove_redundant_words(ngc_word_t *words, int count)
+{
+	bool nonmodal = false;
+	bool programend = false;
+	int motion = -1;
+
+	for (int i = 0; i < count; i++)
+	{
+		const ngc_word_t *w = &words[i];
+		if (w->letter == 'G')
+		{
+			if (is_gcode(w, 4, 0) || is_gcode(w, 10, 0) || is_gcode(w, 28, 0) || is_gcode(w, 30, 0) || is_gcode(w, 53, 0) || is_gcode(w, 92, 0) || (w->mantissa / 10 == 92 && w->decimals == 1))
+			{
+				nonmodal = true;
+			}
+			else if (is_gcode(w, 20, 0) || is_gcode(w, 21, 0))
+			{
+				//units change the meaning of F
+				feed = -1;
+			}
+			else if (is_gcode(w, 93, 0) || is_gcode(w, 94, 0))
+			{
+				feed_mode = (int)w->mantissa;
+				feed = -1;
+			}
+			else if (w->decimals == 0 && w->mantissa >= 0 && w->mantissa <= 3)
+			{
+				motion = (int)w->mantissa;
+			}
+			else if (is_gcode(w, 5, 0) || is_gcode(w, 51, 1) || is_gcode(w, 80, 0) || w->mantissa / 10 == 38 || (w->decimals == 0 && w->mantissa >= 81 && w->mantissa <= 89))
+			{
+				//splines, probing and canned cycles are always sent (the motion mode is unknown after them)
+				motion_mode = -1;
+			}
+		}
+		else if (w->letter == 'M' && w->decimals == 0 && (w->mantissa == 2 || w->mantissa == 30))
+		{
+			programend = true;
+		}
+	}
+
+	int j = count;
+	if (nonmodal)
+	{
+		reset_modal_state();
+	}
+	else if (feed_mode != 94) //in inverse time mode (G93) all words are needed
+	{
+		if (motion >= 0)
+		{
+			motion_mode = motion;
+		}
+		feed = -1;
+	}
+	else
+	{
+		j = 0;
+		for (int i = 0; i < count; i++)
+		{
+			ngc_word_t *w = &words[i];
+			if (w->letter == 'G' && w->decimals == 0 && w->mantissa == motion)
+			{
+				if (motion == motion_mode)
+				{
+					continue;
+				}
+				motion_mode = motion;
+			}
+			else if (w->letter == 'F')
+			{
+				if (w->value == feed)
+				{
+					continue;
+				}
+				feed = w->value;
+			}
+
+			words[j++] = *w;
+		}
+	}
+
+	if (programend)
+	{
+		//the parser is reset to G1, G21 and G94
+		reset_modal_state();
+		motion_mode = 1;
+		feed_mode = 94;
+	}
+
+	return j;
+}
+
+static bool is_program_end(const ngc_word_t *words, int count)
+{
+	for (int i = 0; i < count; i++)
+	{
+		if (words[i].letter == 'M' && words[i].decimals == 0 && (words[i].mantissa == 2 || words[i].mantissa == 30))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/*
+	Encodes a block in a binary frame
+	The motion word (or the current motion mode if the block only has axis words) is sent in the opcode
+	Returns the frame size or 0 if the block can't be encoded
+*/
+static size_t encode_block(const ngc_word_t *words, int count, bool keep, uint8_t *frame)
+{
+	static const uint8_t delta_order[BINARY_GCODE_DELTA_WORDS] = {BINARY_GCODE_DELTA_N, BINARY_GCODE_DELTA_X, BINARY_GCODE_DELTA_Y, BINARY_GCODE_DELTA_Z, BINARY_GCODE_DELTA_A, BINARY_GCODE_DELTA_B, BINARY_GCODE_DELTA_C};
+	int64_t values[BINARY_GCODE_DELTA_WORDS];
+	const ngc_word_t *others[MAX_WORDS];
+	int othercount = 0;
+	uint8_t op = BINARY_GCODE_SOF;
+	uint8_t mask = 0;
+	bool hasgcode = false;
+	uint8_t *payload = &frame[2];
+	size_t len = 1;
+
+	for (int i = 0; i < count; i++)
+	{
+		const ngc_word_t *w = &words[i];
+		int index = delta_word_index(w->letter);
+		if (index >= 0)
+		{
+			//repeated words are left to the controller to reject
+			if ((mask & (1 << index)) || w->decimals > 4 || !fits(scale(w, 4), INT32_MIN, INT32_MAX))
+			{
+				return 0;
+			}
+
+			values[index] = scale(w, 4);
+			mask |= (1 << index);
+			continue;
+		}
+
+		if (w->letter == 'G')
+		{
+			if (op == BINARY_GCODE_SOF && w->decimals == 0 && w->mantissa >= 0 && w->mantissa <= 3)
+			{
+				op = BINARY_GCODE_MOTION(w->mantissa);
+				continue;
+			}
+			hasgcode = true;
+		}
+
+		others[othercount++] = w;
+	}
+
+	//axis words without any other G word are a move in the current motion mode
+	if (!keep && op == BINARY_GCODE_SOF && !hasgcode && motion_mode >= 0 && (mask & ~(1 << BINARY_GCODE_DELTA_N)))
+	{
+		op = BINARY_GCODE_MOTION(motion_mode);
+	}
+
+	for (int i = 0; i < BINARY_GCODE_DELTA_WORDS && len <= BINARY_GCODE_MAX_PAYLOAD; i++)
+	{
+		uint8_t index = delta_order[i];
+		if (mask & (1 << index))
+		{
+			int64_t delta = values[index] - delta_last[index];
+			size_t size = 0;
+			if (index == BINARY_GCODE_DELTA_N)
+			{
+				//line numbers are sent without the scale
+				if (!(delta % 10000) && fits(delta / 10000, INT32_MIN, INT32_MAX))
+				{
+					size = encode_number((uint32_t)zigzag(delta / 10000), &payload[len]);
+				}
+			}
+			else if (fits(delta, INT32_MIN, INT32_MAX))
+			{
+				size = encode_delta(delta, &payload[len]);
+			}
+
+			if (!size)
+			{
+				return 0;
+			}
+			len += size;
+		}
+	}
+
+	for (int i = 0; i < othercount && len <= BINARY_GCODE_MAX_PAYLOAD; i++)
+	{
+		size_t size = encode_word(others[i], &payload[len]);
+		if (!size)
+		{
+			return 0;
+		}
+		len += size;
+	}
+
+	if (len > BINARY_GCODE_MAX_PAYLOAD)
+	{
+		return 0;
+	}
+
+	//the controller updates the last values when the frame is decoded
+	for (int i = 0; i < BINARY_GCODE_DELTA_WORDS; i++)
+	{
+		if (mask & (1 << i))
+		{
+			delta_last[i] = values[i];
+		}
+	}
+
+	uint8_t crc = 0;
+	frame[0] = op;
+	frame[1] = (uint8_t)len;
+	payload[0] = mask;
+	for (size_t i = 1; i < len + 2; i++)
+	{
+		crc = crc7(frame[i], crc);
+	}
+	frame[len + 2] = crc;
+
+	return len + 3;
+}
+
+static void usage(const char *name)
+{
+	fprintf(stderr, "usage: %s [-k] [-f] input.ngc output.bin\n", name);
+	fprintf(stderr, "  -k  keep all words (don't remove redundant modal words)\n");
+	fprintf(stderr, "  -f  wrap each block in a transport frame for the framed streaming mode ($P=1)\n");
+}
+
+int main(int argc, char **argv)
+{
+	bool keep = false;
+	bool framed = false;
+	uint8_t seq = 0;
+	int arg = 1;
+
+	for (; arg < argc && argv[arg][0] == '-'; arg++)
+	{
+		if (!strcmp(argv[arg], "-k"))
+		{
+			keep = true;
+		}
+		else if (!strcmp(argv[arg], "-f"))
+		{
+			framed = true;
+		}
+		else
+		{
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	if (argc - arg != 2)
+	{
+		usage(argv[0]);
+		return 1;
+	}
+
+	FILE *in = fopen(argv[arg], "r");
+	if (!in)
+	{
+		perror(argv[arg]);
+		return 1;
+	}
+
+	FILE *out = fopen(argv[arg + 1], "wb");
+	if (!out)
+	{
+		perror(argv[arg + 1]);
+		fclose(in);
+		return 1;
+	}
+
+	char line[LINE_MAX_LEN];
+	char clean[LINE_MAX_LEN];
+	ngc_word_t words[MAX_WORDS];
+	unsigned long linenum = 0;
+	unsigned long blocks = 0;
+	unsigned long ascii_bytes = 0;
+	unsigned long binary_bytes = 0;
+
+	while (fgets(line, sizeof(line), in))
+	{
+		linenum++;
+		size_t len = clean_line(line, clean);
+		if (!len)
+		{
+			continue;
+		}
+
+		blocks++;
+		//original size as it would be streamed (cleaned line plus '\n')
+		ascii_bytes += len + 1;
+
+		if (clean[0] == '$')
+		{
+			//system commands are sent as ASCII
+			reset_all_modal_state();
+			if (clean[1] == 'P' || clean[1] == 'F')
+			{
+				//the controller clears the last values of the delta coded words
+				memset(delta_last, 0, sizeof(delta_last));
+			}
+			binary_bytes += write_ascii(out, clean, len, framed, &seq);
+			continue;
+		}
+
+		int count = tokenize(clean, words);
+		if (count < 0)
+		{
+			fprintf(stderr, "%s:%lu: invalid gcode line\n", argv[arg], linenum);
+			fclose(in);
+			fclose(out);
+			return 1;
+		}
+
+		bool programend = is_program_end(words, count);
+		if (!keep)
+		{
+			count = remove_redundant_words(words, count);
+		}
+
+		//the largest word can exceed the maximum payload by 7 bytes before the encoder stops
+		uint8_t frame[3 + BINARY_GCODE_MAX_PAYLOAD + 8];
+		size_t size = encode_block(words, count, keep, frame);
+		if (size)
+		{
+			binary_bytes += write_block(out, frame, size, framed, &seq);
+		}
+		else
+		{
+			//doesn't fit in a frame
+			reset_modal_state();
+			binary_bytes += write_ascii(out, clean, len, framed, &seq);
+		}
+
+		if (programend)
+		{
+			//the controller clears the last values of the delta coded words on a program end
+			memset(delta_last, 0, sizeof(delta_last));
+		}
+	}
+
+	fclose(in);
+	fclose(out);
+
+	fprintf(stderr, "%lu blocks, %lu ASCII bytes -> %lu binary bytes", blocks, ascii_bytes, binary_bytes);
+	if (binary_bytes)
+	{
+		fprintf(stderr, " (%.2fx)", (double)ascii_bytes / (double)binary_bytes);
+	}
+	fprintf(stderr, "\n");
+
+	return 0;
+}
@@ -0,0 +1,107 @@
+/*
+	Name: binary_gcode.h
+	Description: Compact binary encoding of RS274NGC blocks for uCNC.
+		Each block is sent in a frame with the following layout:
+			- Opcode byte (BINARY_GCODE_SOF or BINARY_GCODE_MOTION(n) that also implies the motion word G0 to G3)
+			- Length byte (number of payload bytes)
+			- Payload
+				- Word mask byte (the delta coded words present in the block)
+				- Delta coded words (N first and then the axis words from X to C)
+				- Other words (a header byte with the word letter index (bits 4..0) and the scale (bits 6..5) followed by the value)
+			- CRC7 of the length byte and payload (same CRC used by the settings)
+		All bytes of the frame are 7 bit values. Numbers are sent as variable length integers (6 data bits per byte,
+		least significant bits first, bit 6 set on all bytes except the last) in zigzag format (the sign is bit 0).
+		Decimal values are sent in fixed point (scaled integers). The scale selects 0, 1, 3 or 4 decimal places.
+		The delta coded words are sent as the difference from the last value received for the same word
+		in a binary frame with the scale in the bits 1..0 of the number (except N that is always an integer).
+		Words that don't change are omitted.
+		The last values are cleared on a soft reset, a program end (M2/M30), $P and at the start of a stored program ($F).
+		Realtime commands can also be sent inside a frame. The bytes after the opcode with the value of an ASCII realtime
+		command (or BINARY_GCODE_ESC) are sent as BINARY_GCODE_ESC followed by the value xor BINARY_GCODE_ESC_XOR.
+		A frame is aborted if the next byte takes more than BINARY_GCODE_TIMEOUT ms and is answered with error:14.
+		Frames longer than BINARY_GCODE_MAX_PAYLOAD are skipped to the end and answered with error:14.
+		The host side encoder is available in tools/ngc2bin.
+
+	Copyright: Copyright (c) João Martins
+	Author: João Martins
+	Date: 19/10/2026
+
+	uCNC is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version. Please see <http://www.gnu.org/licenses/>
+
+	uCNC is distributed WITHOUT ANY WARRANTY;
+	Also without the implied warranty of	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+	See the	GNU General Public License for more details.
+*/
+
+#ifndef BINARY_GCODE_H
+#define BINARY_GCODE_H
+
+//frame start byte of a block without an implied motion word (ASCII STX). This is not a valid gcode char nor a realtime command
+#define BINARY_GCODE_SOF 0x02
+//frame start byte of a block that implies the motion word G0 to G3 (ASCII DLE to DC3)
+#define BINARY_GCODE_MOTION(mode) (0x10 | (mode))
+#define BINARY_GCODE_IS_MOTION(op) (((op)&0xFC) == 0x10)
+#define BINARY_GCODE_MOTION_MODE(op) ((op)&0x03)
+#define BINARY_GCODE_IS_FRAME(op) ((op) == BINARY_GCODE_SOF || BINARY_GCODE_IS_MOTION(op))
+//maximum payload length of a single block
+#define BINARY_GCODE_MAX_PAYLOAD 64
+//maximum time between two bytes of a frame (ms)
+#define BINARY_GCODE_TIMEOUT 100
+
+//realtime commands inside a frame (soft reset, feed hold, status report, cycle start and all extended commands)
+#define BINARY_GCODE_IS_REALTIME(c) ((c) == 0x18 || (c) == '!' || (c) == '?' || (c) == '~' || ((c)&0x80))
+//escape byte (ASCII ESC)
+#define BINARY_GCODE_ESC 0x1B
+#define BINARY_GCODE_ESC_XOR 0x40
+
+//variable length integers
+#define BINARY_GCODE_NUMBER_MORE 0x40
+#define BINARY_GCODE_NUMBER_BITS 0x3F
+#define BINARY_GCODE_NUMBER_SHIFT 6
+
+//number scales (number of decimal places)
+#define BINARY_GCODE_SCALE_1 0		//integer
+#define BINARY_GCODE_SCALE_10 1		//1 decimal place
+#define BINARY_GCODE_SCALE_1000 2	//3 decimal places (um)
+#define BINARY_GCODE_SCALE_10000 3	//4 decimal places (0.1um or 0.0001inch)
+//the delta coded words are kept with 4 decimal places
+#define BINARY_GCODE_DELTA_DECIMALS 4
+
+//word header encoding/decoding
+#define BINARY_GCODE_WORD(scale, letter) ((uint8_t)(((scale) << 5) | ((letter) - 'A')))
+#define BINARY_GCODE_WORD_SCALE(header) (((header) >> 5) & 0x03)
+#define BINARY_GCODE_WORD_LETTER(header) (((header)&0x1F) + 'A')
+
+//delta coded words (bit in the word mask)
+#define BINARY_GCODE_DELTA_X 0
+#define BINARY_GCODE_DELTA_Y 1
+#define BINARY_GCODE_DELTA_Z 2
+#define BINARY_GCODE_DELTA_A 3
+#define BINARY_GCODE_DELTA_B 4
+#define BINARY_GCODE_DELTA_C 5
+#define BINARY_GCODE_DELTA_N 6
+#define BINARY_GCODE_DELTA_WORDS 7
+
+/*
+	Framed streaming mode (enabled with $P=1 and disabled with $P=0 or a soft reset)
+	Each block (an ASCII line without the line end or a complete binary gcode frame) is sent in a transport frame:
+		- SOH byte (BINARY_GCODE_FRAME_SOH)
+		- Sequence number (incremented by one on each new frame starting at 0)
+		- Length byte (number of payload bytes)
+		- Payload
+		- CRC16-CCITT (poly 0x1021, initial value 0xFFFF) of the sequence, length and payload bytes (MSB first)
+	Bytes outside the frames are only interpreted as realtime commands.
+	Binary gcode frames are sent inside the transport frames without escaping.
+	The controller answers with [ACK:n] when frames up to n were accepted (cumulative) and with [NAK:n] when
+	frame n must be sent again (bad CRC, frame lost or no room in the RX buffer). The sender then resends from
+	frame n onwards (go-back-N). ok/error responses are still sent for each executed block.
+*/
+#define BINARY_GCODE_FRAME_SOH 0x01
+#define BINARY_GCODE_FRAME_MAX_PAYLOAD 96
+//maximum number of unacknowledged frames (must be smaller than half of the sequence range)
+#define BINARY_GCODE_FRAME_WINDOW 8
+
+#endif
@@ -35,20 +35,33 @@
 #include "planner.h"
 #include "interpolator.h"
 #include "io_control.h"
+#include "storage.h"
+#include "heightmap.h"
 #include "cnc.h"
 
+//realtime commands queue size (must be a power of 2)
+#define RT_CMD_QUEUE_SIZE 16
+
 typedef struct
 {
     //uint8_t system_state;		//signals if CNC is system_state and gcode can run
     volatile uint8_t exec_state;
     uint8_t active_alarm;
-    volatile uint8_t rt_cmd;
+    //reset and status report requests are flagged apart from the queue
+    //reset can never be dropped and repeated report requests are merged in a single report
+    volatile bool rt_reset;
+    volatile bool rt_report;
+    //single producer (ISR) single consumer (main loop) queue
+    uint8_t rt_cmd_queue[RT_CMD_QUEUE_SIZE];
+    volatile uint8_t rt_cmd_write;
+    volatile uint8_t rt_cmd_read;
 } cnc_state_t;
 
 static cnc_state_t cnc_state;
 
 static void cnc_check_fault_systems();
 static bool cnc_check_interlocking();
+static void cnc_exec_rt_commands();
 static void cnc_exec_rt_command(uint8_t command);
 static void cnc_reset();
 
@@ -67,6 +80,9 @@ void cnc_init()
 	mc_init();		//motion control
 	planner_init();	//motion planner
 	itp_init();		//interpolator
+	#ifdef ENABLE_HEIGHTMAP
+	hmap_init();	//height map
+	#endif
 	
 	serial_flush();
 }
@@ -81,6 +97,10 @@ void cnc_run()
 		if(!serial_rx_is_empty())
 		{
 			uint8_t error = 0;
+			#ifdef ENABLE_PROGRAM_STORAGE
+			//commands read from the storage are not acknowledged to the host (only the errors)
+			bool stored = storage_is_running();
+			#endif
 			//protocol_echo();
 			uint8_t c = serial_peek();
 			switch(c)
@@ -88,6 +108,10 @@ void cnc_run()
 				case '\n':
 					serial_getc();
 					break;
+				case SERIAL_RX_OVERFLOW:
+					serial_getc();
+					error = STATUS_LINE_LENGTH_EXCEEDED;
+					break;
 				case '$':
 					serial_getc();
 					error = parser_grbl_command();
@@ -106,6 +130,9 @@ void cnc_run()
 			
 			if(!error)
 			{
+				#ifdef ENABLE_PROGRAM_STORAGE
+				if(!stored)
+				#endif
 				protocol_send_ok();
 			}
 			else
@@ -126,32 +153,59 @@ void cnc_run()
 		protocol_send_string(MSG_FEEDBACK_1);
 		do
 		{
-		}while(cnc_state.rt_cmd != RT_CMD_RESET);
+		}while(!cnc_state.rt_reset);
 	}
 }
 
 void cnc_call_rt_command(uint8_t command)
 {
-	if(!cnc_state.rt_cmd || cnc_state.rt_cmd == RT_CMD_REPORT)
+	switch(command)
 	{
-		cnc_state.rt_cmd = command;
+		case RT_CMD_RESET:
+			cnc_state.rt_reset = true;
+			break;
+		case RT_CMD_REPORT:
+			cnc_state.rt_report = true;
+			break;
+		default:
+			//other ASCII chars are not realtime commands (white spaces, etc...) and are discarded
+			if(command < 0x80 && command != RT_CMD_FEED_HOLD && command != RT_CMD_CYCLE_START)
+			{
+				break;
+			}
+			
+			{
+				uint8_t write = cnc_state.rt_cmd_write;
+				uint8_t next = (write + 1) & (RT_CMD_QUEUE_SIZE - 1);
+				//if the queue is full the command is discarded
+				if(next != cnc_state.rt_cmd_read)
+				{
+					cnc_state.rt_cmd_queue[write] = command;
+					cnc_state.rt_cmd_write = next;
+				}
+			}
+			break;
 	}
 }
 
 void cnc_doevents()
 {
-	//check if RT commands are pending execution
-	if(cnc_state.rt_cmd)
-	{
-		cnc_exec_rt_command(cnc_state.rt_cmd);
-		cnc_state.rt_cmd = 0; //clears the rt_cmd for the next instruction
-	}
+	//executes pending RT commands
+	cnc_exec_rt_commands();
+	
+	protocol_send_auto_status();
+	protocol_send_frame_acks();
+	
+	#ifdef ENABLE_PROGRAM_STORAGE
+	storage_prefetch();
+	#endif
 	
 	if(!cnc_check_interlocking())
 	{
 		return;
 	}	
 
+	mc_run();
 	itp_run();
 }
 
@@ -171,13 +225,16 @@ void cnc_home()
 	cnc_unlock();
 
 	float target[AXIS_COUNT];
-	planner_block_data_t block_data;
+	planner_block_data_t block_data = {};
 	planner_get_position(target);
 	
 	for(uint8_t i = AXIS_COUNT; i != 0;)
 	{
 		i--;
-		target[i] += ((g_settings.homing_dir_invert_mask & (1<<i)) ? -g_settings.homing_offset : g_settings.homing_offset);
+		if(HOMING_AXIS_MASK & (1<<i))
+		{
+			target[i] += ((g_settings.homing_dir_invert_mask & (1<<i)) ? -g_settings.homing_offset : g_settings.homing_offset);
+		}
 	}
 	
 	block_data.feed = g_settings.homing_fast_feed_rate * MIN_SEC_MULT;
@@ -192,6 +249,7 @@ void cnc_home()
 	//reset position
 	itp_reset_rt_position();
 	planner_resync_position();
+	mc_resync_position();
 }
 
 void cnc_alarm(uint8_t code)
@@ -273,14 +331,21 @@ void cnc_clear_exec_state(uint8_t statemask)
 
 void cnc_reset()
 {
-	cnc_state.rt_cmd = 0;
+	cnc_state.rt_reset = false;
+	cnc_state.rt_report = false;
+	cnc_state.rt_cmd_read = cnc_state.rt_cmd_write;
 	cnc_state.active_alarm = EXEC_ALARM_RESET;
 	cnc_state.exec_state = EXEC_ALARM | EXEC_HOLD; //Activates all alarms and hold
 	
 	//clear all systems
 	itp_clear();
 	planner_clear();
-	serial_clear();		
+	mc_clear();
+	parser_clear();
+	serial_clear();
+	#ifdef ENABLE_PROGRAM_STORAGE
+	storage_close();
+	#endif
 	protocol_send_string(MSG_STARTUP);
 	//tries to clear alarms or active hold state
 	cnc_clear_exec_state(EXEC_ALARM | EXEC_HOLD);
@@ -301,17 +366,60 @@ void cnc_reset()
 	}*/
 }
 
+void cnc_exec_rt_commands()
+{
+	//reset has precedence over all other commands and discards them
+	if(cnc_state.rt_reset)
+	{
+		cnc_state.rt_reset = false;
+		cnc_state.rt_cmd_read = cnc_state.rt_cmd_write;
+		cnc_stop();
+		cnc_alarm(EXEC_ALARM_RESET);
+		return;
+	}
+	
+	if(cnc_state.rt_report)
+	{
+		cnc_state.rt_report = false;
+		//if the TX buffer has no room for the report it's deferred to the next cycle
+		if(!protocol_send_status())
+		{
+			cnc_state.rt_report = true;
+		}
+	}
+	
+	#ifdef USE_SPINDLE
+	bool update_spindle = false;
+	#endif
+	//all queued commands are executed in a single pass
+	//this way a burst of overrides is applied as a single update of the running motion and spindle
+	uint8_t read = cnc_state.rt_cmd_read;
+	while(read != cnc_state.rt_cmd_write)
+	{
+		uint8_t command = cnc_state.rt_cmd_queue[read];
+		read = (read + 1) & (RT_CMD_QUEUE_SIZE - 1);
+		cnc_state.rt_cmd_read = read;
+		cnc_exec_rt_command(command);
+		#ifdef USE_SPINDLE
+		if(command>=RT_CMD_SPINDLE_100 && command<=RT_CMD_SPINDLE_DEC_FINE)
+		{
+			update_spindle = true;
+		}
+		#endif
+	}
+	
+	#ifdef USE_SPINDLE
+	if(update_spindle)
+	{
+		planner_update_spindle(true);
+	}
+	#endif
+}
+
 void cnc_exec_rt_command(uint8_t command)
 {
 	switch(command)
 	{
-		case RT_CMD_REPORT:
-			protocol_send_status();
-			break;
-		case RT_CMD_RESET:
-			cnc_stop();
-			cnc_alarm(EXEC_ALARM_RESET);
-			break;
 		case RT_CMD_SAFETY_DOOR:
 			cnc_set_exec_state(EXEC_DOOR|EXEC_HOLD);
 			protocol_send_string(MSG_FEEDBACK_6);
@@ -403,13 +511,6 @@ void cnc_exec_rt_command(uint8_t command)
 			break;
 		#endif
 	}
-	
-	#ifdef USE_SPINDLE
-	if(command>=RT_CMD_SPINDLE_100 && command<=RT_CMD_SPINDLE_DEC_FINE)
-	{
-		planner_update_spindle(true);
-	}
-	#endif
 }
 
 void cnc_check_fault_systems()
@@ -473,6 +574,7 @@ bool cnc_check_interlocking()
 		{
 			itp_clear();
 			planner_clear();
+			mc_clear();
 			CLEARFLAG(cnc_state.exec_state, EXEC_HOMING | EXEC_JOG | EXEC_HOLD);
 		}
 		
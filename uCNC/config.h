@@ -36,6 +36,36 @@
 */
 #define MACHINE_KINEMATICS MACHINE_CARTESIAN_XYZ
 
+/*
+	Segmentation of linear motions for non linear kinematics (delta, ...)
+	Lines are split in segments at a rate of KINEMATICS_SEGMENTS_PER_SECOND (at the programmed feed)
+	but segments are never shorter than KINEMATICS_MIN_SEGMENT_LENGTH (in mm)
+*/
+#define KINEMATICS_SEGMENTS_PER_SECOND 100
+#define KINEMATICS_MIN_SEGMENT_LENGTH 0.2f
+
+/*
+	Rotary A axis (cartesian machines only)
+	Adds a 4th axis (A) driven by the 4th stepper (STEP3 and DIR3 pins) that rotates in degrees
+	($103 is in steps per degree, $113 in degrees/min and $123 in degrees/s^2)
+	The A position is kept between 0 and 360 degrees. Absolute (G90) motions move A to the target angle by the shortest path
+	(less than half a turn per motion) and incremental (G91) motions keep the commanded travel (multi turn motions are possible).
+	The soft limits don't apply to A.
+	The F word sets the feed of the linear axis (the A speed follows). Motions of A alone use F in degrees/min.
+	Uncomment to enable
+*/
+//#define ENABLE_ROTARY_AXIS_A
+
+/*
+	Skew and scale compensation (cartesian and coreXY machines only)
+	Corrects the squareness and scale errors of the X, Y and Z axis measured on the machine
+	$40, $41 and $42 are the measured XY, XZ and YZ skew (X deviation in mm per mm of Y, X deviation per mm of Z
+	and Y deviation per mm of Z) and $140, $141 and $142 are the measured scale of X, Y and Z (traveled distance / programmed distance)
+	The kinematics apply the inverse of the measured error to every position (a few multiply-adds per motion)
+	Uncomment to enable
+*/
+//#define ENABLE_SKEW_COMPENSATION
+
 //defines the uCNC generic mapping
 #include "mcumap.h"
 
@@ -46,6 +76,25 @@
 */
 #define BAUD 115200
 
+/*
+	Serial RX buffer size in bytes (sizes above 255 bytes use 16 bit indexes)
+	and the maximum number of complete commands in the RX buffer (must be a power of 2 between 4 and 32)
+	Commands that don't fit in the buffer are discarded and answered with error:14 (line length exceeded)
+	If the commands ring is full the next lines are kept in the last command entry (every line still gets a response)
+*/
+#define RX_BUFFER_SIZE 128
+#define RX_LINE_COUNT 32
+
+/*
+	Number of validated motion blocks that wait in the motion control for free space in the planner
+	The parser keeps executing (and acknowledging) lines while the planner is full until this queue is also full
+	Each entry uses the RAM of a target position plus a planner block data (about 44 bytes on a 3 axis machine)
+	The mcu map can set a smaller queue on mcus with little RAM
+*/
+#ifndef MC_BUFFER_SIZE
+#define MC_BUFFER_SIZE 4
+#endif
+
 /*
 	Defines the number of supported coordinate systems supported by uCNC
 	Can be any value between 1 and 9
@@ -121,7 +170,7 @@
 /*
 	G-code options
 */
-#define GCODE_IGNORE_LINE_NUMBERS
+//#define GCODE_IGNORE_LINE_NUMBERS
 //#define GCODE_ACCEPT_WORD_E
 
 /*
@@ -142,4 +191,38 @@
 
 #define DELAY_ON_RESUME 4
 
+/*
+	Check mode ($C) simulation
+	When enabled the motions in check mode are sent to the planner and the interpolator
+	but run on a virtual clock (no steps or spindle outputs are generated).
+	When check mode is disabled the estimated cycle time, peak feed reached and number of
+	motions starting from a full stop are reported.
+	Comment to simply skip the planner in check mode (saves some program memory)
+*/
+#define ENABLE_CHECKMODE_SIMULATION
+
+/*
+	Program storage
+	Enables running the gcode program stored in the mcu storage device with the $F command
+	(a host file in the virtual mcu and an external flash or SD card block device in real mcus)
+	The program is read in blocks of STORAGE_BLOCK_SIZE bytes to a double buffer (the next block is prefetched while the current is parsed)
+	Only enabled if the mcu map has a storage device (the map sets the STORAGE_BLOCK_SIZE of the device)
+	Comment to disable (saves the RAM used by the read buffers)
+*/
+#ifdef STORAGE_BLOCK_SIZE
+#define ENABLE_PROGRAM_STORAGE
+#endif
+
+/*
+	Height map (bed leveling) compensation
+	$L=X<length>Y<length>Z<depth>F<feed> probes a grid of HEIGHTMAP_GRID_X by HEIGHTMAP_GRID_Y points that starts at the current
+	position and spans the given XY lengths (each point is probed down to the given depth and the tool returns to the start height)
+	After probing the Z of all motions is compensated by the bilinear interpolation of the grid and the grid is stored
+	$L prints the grid and $LC disables the compensation
+	Uncomment to enable (uses 4 bytes of RAM per grid point)
+*/
+//#define ENABLE_HEIGHTMAP
+#define HEIGHTMAP_GRID_X 5
+#define HEIGHTMAP_GRID_Y 5
+
 #endif
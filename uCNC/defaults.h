@@ -37,7 +37,12 @@
 #define DEFAULT_B_MAX_FEED 500
 #define DEFAULT_C_MAX_FEED 500
 
+#if(MACHINE_KINEMATICS == MACHINE_DELTA)
+//delta carriages home to the top of the towers (Z positive)
+#define DEFAULT_HOMING_DIR_INV_MASK 4
+#else
 #define DEFAULT_HOMING_DIR_INV_MASK 0
+#endif
 #define DEFAULT_HOMING_SLOW 10
 #define DEFAULT_HOMING_FAST 50
 #define DEFAULT_HOMING_OFFSET 2
@@ -54,12 +59,34 @@
 #define DEFAULT_X_MAX_DIST 200
 #define DEFAULT_Y_MAX_DIST 200
 #define DEFAULT_Z_MAX_DIST 200
+#define DEFAULT_A_MAX_DIST 200
+#define DEFAULT_B_MAX_DIST 200
+#define DEFAULT_C_MAX_DIST 200
+
+//default delta geometry in mm (diagonal rod length and horizontal distance between the effector and carriage joints)
+#define DEFAULT_DELTA_ARM_LENGTH 230
+#define DEFAULT_DELTA_RADIUS 100
+
+//default SCARA geometry (upper arm and forearm lengths in mm and the joint angles at the homing switches in degrees)
+#define DEFAULT_SCARA_UPPER_ARM_LENGTH 150
+#define DEFAULT_SCARA_FOREARM_LENGTH 150
+#define DEFAULT_SCARA_SHOULDER_HOME_ANGLE 0
+#define DEFAULT_SCARA_ELBOW_HOME_ANGLE 90
+
+//default skew compensation (no skew and no scale error)
+#define DEFAULT_SKEW_XY 0
+#define DEFAULT_SKEW_XZ 0
+#define DEFAULT_SKEW_YZ 0
+#define DEFAULT_X_SCALE 1
+#define DEFAULT_Y_SCALE 1
+#define DEFAULT_Z_SCALE 1
 
 #define DEFAULT_STEP_INV_MASK 0
 #define DEFAULT_STEP_ENA_INV 0
 #define DEFAULT_DIR_INV_MASK 0
 
-#define DEFAULT_STATUS_MASK 1
+#define DEFAULT_STATUS_MASK 9
+#define DEFAULT_STATUS_REPORT_INTERVAL 0
 #define DEFAULT_CONTROL_INV_MASK 0
 #define DEFAULT_LIMIT_INV_MASK 0
 #define DEFAULT_PROBE_INV_MASK 0
@@ -69,6 +69,7 @@
 #define STATUS_INVALID_TOOL 40
 #define STATUS_UNDEFINED_AXIS 41
 #define STATUS_FEED_NOT_SET 42
+#define STATUS_BAD_CHECKSUM 43
 
 #define EXEC_ALARM_RESET					  0
 // Grbl alarm codes. Valid values (1-255). Zero is reserved.
@@ -84,6 +85,12 @@
 #define EXEC_ALARM_HOMING_FAIL_DUAL_APPROACH  10
 #define EXEC_ALARM_HOMING_FAIL_LIMIT_ACTIVE   11
 
+//status report mask ($10)
+#define REPORT_MASK_MPOS 1 //reports machine position (MPos) instead of work position (WPos)
+#define REPORT_MASK_BUFFER 2 //reports planner and serial RX buffer free space (Bf)
+#define REPORT_MASK_LINENUM 4 //reports the line number (Ln)
+#define REPORT_MASK_PINS 8 //reports the active input pins (Pn)
+
 //formated messages
 #define MSG_OK __romstr__("ok\r\n")
 #define MSG_ERROR __romstr__("error:")
@@ -0,0 +1,292 @@
+/*
+	Name: heightmap.c
+	Description: Height map (bed leveling) compensation for uCNC.
+		The grid has HEIGHTMAP_GRID_X by HEIGHTMAP_GRID_Y points and stores the probed Z of each point relative to the first point.
+		The cell under a XY position is found by arithmetic (no searches) and the Z offset is the bilinear interpolation of the cell corners.
+		The motion control splits the lines at the cell borders so that the offset changes linearly along each segment.
+		The height map is stored in the non volatile memory after the settings.
+
+	Copyright: Copyright (c) João Martins
+	Author: João Martins
+	Date: 19/10/2026
+
+	uCNC is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version. Please see <http://www.gnu.org/licenses/>
+
+	uCNC is distributed WITHOUT ANY WARRANTY;
+	Also without the implied warranty of	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+	See the	GNU General Public License for more details.
+*/
+
+#include <math.h>
+#include <string.h>
+#include <float.h>
+#include "config.h"
+#include "grbl_interface.h"
+#include "settings.h"
+#include "machinedefs.h"
+#include "planner.h"
+#include "interpolator.h"
+#include "motion_control.h"
+#include "parser.h"
+#include "cnc.h"
+#include "heightmap.h"
+
+#ifdef ENABLE_HEIGHTMAP
+
+#if(HEIGHTMAP_GRID_X < 2 || HEIGHTMAP_GRID_Y < 2)
+#error "The height map grid needs at least 2 points in each direction"
+#endif
+
+//split points closer than this fraction of the line to the previous split are skipped
+#define HMAP_BORDER_TOLERANCE 0.000001f
+
+typedef struct
+{
+	//XY position of the first point and size of the cells (the compensation is disabled if the cell size is 0)
+	float origin[2];
+	float cell[2];
+	//Z of each point relative to the first point
+	float z[HEIGHTMAP_GRID_Y][HEIGHTMAP_GRID_X];
+} hmap_t;
+
+#if((8 * 2 + 4 * HEIGHTMAP_GRID_X * HEIGHTMAP_GRID_Y) >= (SETTINGS_PARSER_PARAMETERS_ADDRESS_OFFSET - SETTINGS_HEIGHTMAP_ADDRESS_OFFSET))
+#error "The height map grid is too large to be stored"
+#endif
+
+static hmap_t hmap;
+static float hmap_cell_inv[2];
+
+static void hmap_update()
+{
+	hmap_cell_inv[0] = (hmap.cell[0] != 0) ? (1.0f / hmap.cell[0]) : 0;
+	hmap_cell_inv[1] = (hmap.cell[1] != 0) ? (1.0f / hmap.cell[1]) : 0;
+}
+
+//waits for all queued motions to complete and syncs the motion control position with the compensation state
+static bool hmap_sync()
+{
+	while((!mc_buffer_is_empty() || !planner_buffer_is_empty() || cnc_get_exec_state(EXEC_RUN)) && !cnc_get_exec_state(EXEC_ABORT))
+	{
+		cnc_doevents();
+	}
+
+	mc_resync_position();
+	return !cnc_get_exec_state(EXEC_ABORT);
+}
+
+//loads the stored height map (the compensation is disabled if there is none)
+static void hmap_load()
+{
+	if(!settings_load(SETTINGS_HEIGHTMAP_ADDRESS_OFFSET, (uint8_t*)&hmap, sizeof(hmap_t)))
+	{
+		memset(&hmap, 0, sizeof(hmap_t));
+	}
+
+	hmap_update();
+}
+
+void hmap_init()
+{
+	hmap_load();
+	mc_resync_position();
+}
+
+static uint8_t hmap_probe_grid(float length_x, float length_y, float depth, float feed)
+{
+	float start[AXIS_COUNT];
+	float target[AXIS_COUNT];
+	planner_block_data_t block_data = {};
+
+	//the probing motions are not compensated
+	memset(&hmap, 0, sizeof(hmap_t));
+	hmap_update();
+	if(!hmap_sync())
+	{
+		return EXEC_ALARM_ABORT_CYCLE;
+	}
+
+	mc_get_position(start);
+	memcpy(target, start, sizeof(target));
+	float cell_x = length_x / (HEIGHTMAP_GRID_X - 1);
+	float cell_y = length_y / (HEIGHTMAP_GRID_Y - 1);
+	block_data.motion_mode = PLANNER_MOTION_MODE_FEED;
+
+	for(uint8_t j = 0; j < HEIGHTMAP_GRID_Y; j++)
+	{
+		for(uint8_t k = 0; k < HEIGHTMAP_GRID_X; k++)
+		{
+			//zigzag path
+			uint8_t i = (j & 0x01) ? (HEIGHTMAP_GRID_X - 1 - k) : k;
+			target[AXIS_X] = start[AXIS_X] + i * cell_x;
+			target[AXIS_Y] = start[AXIS_Y] + j * cell_y;
+			if(i != 0 || j != 0)
+			{
+				//the first point is the start position (an empty motion before the probe would not start the interpolator)
+				block_data.feed = FLT_MAX;
+				mc_line(target, block_data);
+			}
+
+			target[AXIS_Z] -= depth;
+			block_data.feed = feed;
+			uint8_t error = mc_probe(target, false, block_data);
+			//discards the rest of the probe motion and releases the hold of the probe hit
+			itp_stop();
+			itp_clear();
+			planner_clear();
+			mc_clear();
+			cnc_clear_exec_state(EXEC_HOLD);
+			if(cnc_get_exec_state(EXEC_ABORT))
+			{
+				return EXEC_ALARM_ABORT_CYCLE;
+			}
+
+			if(error)
+			{
+				return error;
+			}
+
+			hmap.z[j][i] = parser_get_coordsys(255)[AXIS_Z];
+			target[AXIS_Z] = start[AXIS_Z];
+			block_data.feed = FLT_MAX;
+			mc_line(target, block_data);
+		}
+	}
+
+	mc_line(start, block_data);
+	if(!hmap_sync())
+	{
+		return EXEC_ALARM_ABORT_CYCLE;
+	}
+
+	float z0 = hmap.z[0][0];
+	for(uint8_t j = 0; j < HEIGHTMAP_GRID_Y; j++)
+	{
+		for(uint8_t i = 0; i < HEIGHTMAP_GRID_X; i++)
+		{
+			hmap.z[j][i] -= z0;
+		}
+	}
+
+	hmap.origin[0] = start[AXIS_X];
+	hmap.origin[1] = start[AXIS_Y];
+	hmap.cell[0] = cell_x;
+	hmap.cell[1] = cell_y;
+	hmap_update();
+	settings_save(SETTINGS_HEIGHTMAP_ADDRESS_OFFSET, (const uint8_t*)&hmap, sizeof(hmap_t));
+	//the current position is now a compensated position
+	mc_resync_position();
+	return STATUS_OK;
+}
+
+uint8_t hmap_probe(float length_x, float length_y, float depth, float feed)
+{
+	uint8_t error = hmap_probe_grid(length_x, length_y, depth, feed);
+	if(error)
+	{
+		//a failed probe keeps the previous height map (the same that is stored)
+		hmap_load();
+		mc_resync_position();
+	}
+
+	return error;
+}
+
+void hmap_clear()
+{
+	memset(&hmap, 0, sizeof(hmap_t));
+	hmap_update();
+	settings_save(SETTINGS_HEIGHTMAP_ADDRESS_OFFSET, (const uint8_t*)&hmap, sizeof(hmap_t));
+	hmap_sync();
+}
+
+bool hmap_is_active()
+{
+	return (hmap.cell[0] != 0 && hmap.cell[1] != 0);
+}
+
+float hmap_get_offset(float x, float y)
+{
+	if(!hmap_is_active())
+	{
+		return 0;
+	}
+
+	//position in cell units (positions outside of the grid use the border cells)
+	float u = (x - hmap.origin[0]) * hmap_cell_inv[0];
+	float v = (y - hmap.origin[1]) * hmap_cell_inv[1];
+	u = (u > 0) ? u : 0;
+	v = (v > 0) ? v : 0;
+	u = (u < (HEIGHTMAP_GRID_X - 1)) ? u : (HEIGHTMAP_GRID_X - 1);
+	v = (v < (HEIGHTMAP_GRID_Y - 1)) ? v : (HEIGHTMAP_GRID_Y - 1);
+	uint8_t i = (uint8_t)u;
+	uint8_t j = (uint8_t)v;
+	i = (i < (HEIGHTMAP_GRID_X - 2)) ? i : (HEIGHTMAP_GRID_X - 2);
+	j = (j < (HEIGHTMAP_GRID_Y - 2)) ? j : (HEIGHTMAP_GRID_Y - 2);
+	float fx = u - i;
+	float fy = v - j;
+
+	//bilinear interpolation of the cell corners
+	float z00 = hmap.z[j][i];
+	float z10 = hmap.z[j][i + 1];
+	float z01 = hmap.z[j + 1][i];
+	float z11 = hmap.z[j + 1][i + 1];
+	return z00 + fx * (z10 - z00) + fy * (z01 - z00 + fx * (z11 - z01 - z10 + z00));
+}
+
+//fraction of the motion where the next grid line of the axis is crossed
+static float hmap_next_border_axis(float p0, float p1, float t, uint8_t axis, uint8_t count)
+{
+	float d = p1 - p0;
+	if(d == 0)
+	{
+		return 1;
+	}
+
+	float d_inv = 1.0f / d;
+	float u = (p0 + t * d - hmap.origin[axis]) * hmap_cell_inv[axis];
+	int8_t dir = (d > 0) ? 1 : -1;
+	float line = (d > 0) ? (floorf(u) + 1) : (ceilf(u) - 1);
+	//motions that start outside of the grid cross the border first
+	line = (line > 0) ? line : 0;
+	line = (line < (count - 1)) ? line : (count - 1);
+	float next = (hmap.origin[axis] + line * hmap.cell[axis] - p0) * d_inv;
+	if(next <= (t + HMAP_BORDER_TOLERANCE))
+	{
+		//the motion is already at this grid line
+		line += dir;
+		if(line < 0 || line > (count - 1))
+		{
+			return 1;
+		}
+		next = (hmap.origin[axis] + line * hmap.cell[axis] - p0) * d_inv;
+	}
+
+	return (next < 1) ? next : 1;
+}
+
+float hmap_next_border(float* p0, float* p1, float t)
+{
+	float next_x = hmap_next_border_axis(p0[AXIS_X], p1[AXIS_X], t, 0, HEIGHTMAP_GRID_X);
+	float next_y = hmap_next_border_axis(p0[AXIS_Y], p1[AXIS_Y], t, 1, HEIGHTMAP_GRID_Y);
+	return (next_x < next_y) ? next_x : next_y;
+}
+
+bool hmap_get_point(uint8_t index, float* point)
+{
+	uint8_t i = index % HEIGHTMAP_GRID_X;
+	uint8_t j = index / HEIGHTMAP_GRID_X;
+	if(j >= HEIGHTMAP_GRID_Y)
+	{
+		return false;
+	}
+
+	point[0] = hmap.origin[0] + i * hmap.cell[0];
+	point[1] = hmap.origin[1] + j * hmap.cell[1];
+	point[2] = hmap.z[j][i];
+	return true;
+}
+
+#endif
@@ -0,0 +1,45 @@
+/*
+	Name: heightmap.h
+	Description: Height map (bed leveling) compensation for uCNC.
+		A grid of points is probed with the $L command and the Z offset of each motion is computed
+		by bilinear interpolation of the grid cell under the XY position.
+
+	Copyright: Copyright (c) João Martins
+	Author: João Martins
+	Date: 19/10/2026
+
+	uCNC is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version. Please see <http://www.gnu.org/licenses/>
+
+	uCNC is distributed WITHOUT ANY WARRANTY;
+	Also without the implied warranty of	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+	See the	GNU General Public License for more details.
+*/
+
+#ifndef HEIGHTMAP_H
+#define HEIGHTMAP_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "config.h"
+
+#ifdef ENABLE_HEIGHTMAP
+//loads the stored height map
+void hmap_init();
+//probes the grid starting at the current XY position (lengths and depth in mm and feed in mm/s)
+//if the probing fails the previous height map is kept
+uint8_t hmap_probe(float length_x, float length_y, float depth, float feed);
+//disables the compensation and erases the stored height map
+void hmap_clear();
+bool hmap_is_active();
+//Z offset at the given XY position (0 if the compensation is disabled)
+float hmap_get_offset(float x, float y);
+//fraction of the XY motion between p0 and p1 where the next cell border after fraction t is crossed (1 if none)
+float hmap_next_border(float* p0, float* p1, float t);
+//gets the XY position and Z offset of a grid point (returns false if the index is out of the grid)
+bool hmap_get_point(uint8_t index, float* point);
+#endif
+
+#endif
@@ -64,6 +64,9 @@ typedef struct pulse_sgm_
 	uint8_t ticks_per_step;
 	float feed;
 	bool update_speed;
+	#ifndef GCODE_IGNORE_LINE_NUMBERS
+	uint32_t linenum;
+	#endif
 } INTERPOLATOR_SEGMENT;
 
 //circular buffers
@@ -83,6 +86,10 @@ static planner_block_t *itp_cur_plan_block;
 //pointer to the segment being executed
 static INTERPOLATOR_SEGMENT *itp_running_sgm;
 
+#ifndef GCODE_IGNORE_LINE_NUMBERS
+//line number of the segment being executed by the ISR
+static volatile uint32_t itp_rt_linenum;
+#endif
 //stores the current position of the steppers in the interpolator after processing a planner block
 static uint32_t itp_step_pos[STEPPER_COUNT];
 //keeps track of the machine realtime position
@@ -95,6 +102,25 @@ static bool itp_needs_update;
 static uint8_t dirbitsmask[STEPPER_COUNT];
 static volatile bool itp_isr_finnished;
 //static volatile bool itp_running;
+#ifdef ENABLE_CHECKMODE_SIMULATION
+//check mode simulation
+//the motions are consumed by the interpolator on a virtual clock (no steps are output)
+static bool itp_sim;
+static float itp_sim_time;
+static float itp_sim_max_feed;
+static uint16_t itp_sim_stops;
+static bool itp_sim_flush;
+#define itp_sim_is_active() (itp_sim)
+#else
+#define itp_sim_is_active() (false)
+#endif
+#ifdef KINEMATICS_STEPPER_LOCK
+//steppers stopped by their own limit switch (while homing each stepper stops at its switch)
+static volatile uint8_t itp_step_lock;
+#define itp_stepper_is_locked(stepper) (itp_step_lock & (1 << (stepper)))
+#else
+#define itp_stepper_is_locked(stepper) (false)
+#endif
 
 /*
 	Interpolator segment buffer functions
@@ -191,6 +217,9 @@ void itp_init()
 	itp_running_sgm = NULL;
 	itp_cur_plan_block = NULL;
 	itp_needs_update = false;
+	#ifdef ENABLE_CHECKMODE_SIMULATION
+	itp_sim = false;
+	#endif
 	#endif
 	itp_isr_finnished = true;
 
@@ -259,28 +288,58 @@ void itp_run()
 			{
 				break;
 			}
+			#ifdef ENABLE_CHECKMODE_SIMULATION
+			//the simulation is much faster then the gcode stream
+			//blocks are only consumed with a full planner to get the same lookahead of a real run
+			if (itp_sim && !itp_sim_flush && !planner_buffer_is_full())
+			{
+				break;
+			}
+			#endif
 			//get the first block in the planner
 			itp_cur_plan_block = planner_get_block();
 
 			//updates spindle
 			#ifdef USE_SPINDLE
-			planner_update_spindle(true);
+			planner_update_spindle(!itp_sim_is_active());
 			#endif
 
-			if (itp_cur_plan_block->dwell != 0)
+			#ifdef ENABLE_CHECKMODE_SIMULATION
+			if (itp_sim)
 			{
-				itp_delay(itp_cur_plan_block->dwell);
-			}
+				//dwell is in 10ms increments
+				itp_sim_time += 0.01f * itp_cur_plan_block->dwell;
+				if (itp_cur_plan_block->distance == 0)
+				{
+					itp_cur_plan_block = NULL;
+					planner_discard_block();
+					continue;
+				}
 
-			if (itp_cur_plan_block->distance == 0)
+				//motion starts from a full stop
+				if (itp_cur_plan_block->entry_feed_sqr == 0)
+				{
+					itp_sim_stops++;
+				}
+			}
+			else
+			#endif
 			{
 				if (itp_cur_plan_block->dwell != 0)
 				{
-					itp_blk_buffer_write();
+					itp_delay(itp_cur_plan_block->dwell);
+				}
+
+				if (itp_cur_plan_block->distance == 0)
+				{
+					if (itp_cur_plan_block->dwell != 0)
+					{
+						itp_blk_buffer_write();
+					}
+					itp_cur_plan_block = NULL;
+					planner_discard_block();
+					break; //exits after adding the dwell segment if motion is 0 (empty motion block)
 				}
-				itp_cur_plan_block = NULL;
-				planner_discard_block();
-				break; //exits after adding the dwell segment if motion is 0 (empty motion block)
 			}
 
 			//erases previous values
@@ -324,7 +383,8 @@ void itp_run()
 
 			half_speed_change = 0.5f * INTEGRATOR_DELTA_T * itp_cur_plan_block->acceleration;
 
-			uint32_t error = itp_blk_data[itp_blk_data_write].totalsteps >> 1;
+			//the error starts at half step rounded up (with 0 a single step block would never step)
+			uint32_t error = (itp_blk_data[itp_blk_data_write].totalsteps + 1) >> 1;
 			for (uint8_t i = 0; i < STEPPER_COUNT; i++)
 			{
 				itp_blk_data[itp_blk_data_write].errors[i] = error;
@@ -336,6 +396,9 @@ void itp_run()
 
 		sgm = &itp_sgm_data[itp_sgm_data_write];
 		sgm->block = &itp_blk_data[itp_blk_data_write];
+		#ifndef GCODE_IGNORE_LINE_NUMBERS
+		sgm->linenum = itp_cur_plan_block->linenum;
+		#endif
 		//sgm->update_speed = true;
 
 		//if an hold is active forces to deaccelerate
@@ -350,7 +413,7 @@ void itp_run()
 		{
 			//updates spindle
 			#ifdef USE_SPINDLE
-			planner_update_spindle(true);
+			planner_update_spindle(!itp_sim_is_active());
 			#endif
 			
 			itp_needs_update = false;
@@ -479,6 +542,25 @@ void itp_run()
 			itp_cur_plan_block->distance = min_step_distance * deaccel_from;
 		}
 
+		#ifdef ENABLE_CHECKMODE_SIMULATION
+		if (itp_sim)
+		{
+			//the segment is not sent to the step ISR
+			//only the time it would take to execute is accounted for
+			if (current_speed > 0)
+			{
+				itp_sim_time += partial_distance / current_speed;
+			}
+			itp_sim_max_feed = MAX(itp_sim_max_feed, current_speed);
+			if (unprocessed_steps == 0)
+			{
+				itp_cur_plan_block = NULL;
+				planner_discard_block();
+			}
+			continue;
+		}
+		#endif
+
 		itp_sgm_buffer_write();
 
 		if (unprocessed_steps == 0)
@@ -514,6 +596,15 @@ void itp_stop()
 	cnc_clear_exec_state(EXEC_RUN);
 }
 
+#ifdef KINEMATICS_STEPPER_LOCK
+//locked steppers stop stepping while the other steppers continue the motion
+//the lock is released when the interpolator is cleared
+void itp_lock_steppers(uint8_t lockmask)
+{
+	itp_step_lock |= lockmask;
+}
+#endif
+
 void itp_clear()
 {
 	itp_cur_plan_block = NULL;
@@ -524,6 +615,9 @@ void itp_clear()
 	itp_sgm_data_read = 0;
 	itp_sgm_data_slots = INTERPOLATOR_BUFFER_SIZE;
 	itp_blk_clear();
+#ifdef KINEMATICS_STEPPER_LOCK
+	itp_step_lock = 0;
+#endif
 }
 
 void itp_get_rt_position(float *axis)
@@ -538,16 +632,14 @@ void itp_reset_rt_position()
 	if (g_settings.homing_enabled)
 	{
 		float origin[AXIS_COUNT];
+		//the axis without a home position keep the position set by the kinematics homing
+		itp_get_rt_position(origin);
 		for (uint8_t i = AXIS_COUNT; i != 0;)
 		{
 			i--;
-			if (g_settings.homing_dir_invert_mask & (1 << i))
+			if (HOMING_AXIS_MASK & (1 << i))
 			{
-				origin[i] = g_settings.max_distance[i];
-			}
-			else
-			{
-				origin[i] = 0;
+				origin[i] = (g_settings.homing_dir_invert_mask & (1 << i)) ? g_settings.max_distance[i] : 0;
 			}
 		}
 
@@ -557,8 +649,18 @@ void itp_reset_rt_position()
 	{
 		memset(&itp_rt_step_pos, 0, sizeof(itp_rt_step_pos));
 	}
+
+	//the next block steps are computed from the new position
+	memcpy(&itp_step_pos, &itp_rt_step_pos, sizeof(itp_step_pos));
 }
 
+#ifndef GCODE_IGNORE_LINE_NUMBERS
+uint32_t itp_get_rt_linenum()
+{
+	return itp_rt_linenum;
+}
+#endif
+
 float itp_get_rt_feed()
 {
 	float feed = 0;
@@ -609,6 +711,9 @@ void itp_step_reset_isr()
 		{
 			//loads a new segment
 			itp_running_sgm = &itp_sgm_data[itp_sgm_data_read];
+			#ifndef GCODE_IGNORE_LINE_NUMBERS
+			itp_rt_linenum = itp_running_sgm->linenum;
+			#endif
 			cnc_set_exec_state(EXEC_RUN);
 			itp_isr_finnished = false;
 			if(itp_running_sgm->block!=NULL)
@@ -659,14 +764,17 @@ void itp_step_isr()
 			if (itp_running_sgm->block->errors[0] > itp_running_sgm->block->totalsteps)
 			{
 				itp_running_sgm->block->errors[0] -= itp_running_sgm->block->totalsteps;
-				stepbits |= STEP0_MASK;
-				if (itp_running_sgm->block->dirbits & DIR0_MASK)
-				{
-					itp_rt_step_pos[0]--;
-				}
-				else
+				if (!itp_stepper_is_locked(0))
 				{
-					itp_rt_step_pos[0]++;
+					stepbits |= STEP0_MASK;
+					if (itp_running_sgm->block->dirbits & DIR0_MASK)
+					{
+						itp_rt_step_pos[0]--;
+					}
+					else
+					{
+						itp_rt_step_pos[0]++;
+					}
 				}
 			}
 #endif
@@ -675,14 +783,17 @@ void itp_step_isr()
 			if (itp_running_sgm->block->errors[1] > itp_running_sgm->block->totalsteps)
 			{
 				itp_running_sgm->block->errors[1] -= itp_running_sgm->block->totalsteps;
-				stepbits |= STEP1_MASK;
-				if (itp_running_sgm->block->dirbits & DIR1_MASK)
-				{
-					itp_rt_step_pos[1]--;
-				}
-				else
+				if (!itp_stepper_is_locked(1))
 				{
-					itp_rt_step_pos[1]++;
+					stepbits |= STEP1_MASK;
+					if (itp_running_sgm->block->dirbits & DIR1_MASK)
+					{
+						itp_rt_step_pos[1]--;
+					}
+					else
+					{
+						itp_rt_step_pos[1]++;
+					}
 				}
 			}
 #endif
@@ -691,14 +802,17 @@ void itp_step_isr()
 			if (itp_running_sgm->block->errors[2] > itp_running_sgm->block->totalsteps)
 			{
 				itp_running_sgm->block->errors[2] -= itp_running_sgm->block->totalsteps;
-				stepbits |= STEP2_MASK;
-				if (itp_running_sgm->block->dirbits & DIR2_MASK)
+				if (!itp_stepper_is_locked(2))
 				{
-					itp_rt_step_pos[2]--;
-				}
-				else
-				{
-					itp_rt_step_pos[2]++;
+					stepbits |= STEP2_MASK;
+					if (itp_running_sgm->block->dirbits & DIR2_MASK)
+					{
+						itp_rt_step_pos[2]--;
+					}
+					else
+					{
+						itp_rt_step_pos[2]++;
+					}
 				}
 			}
 #endif
@@ -707,14 +821,17 @@ void itp_step_isr()
 			if (itp_running_sgm->block->errors[3] > itp_running_sgm->block->totalsteps)
 			{
 				itp_running_sgm->block->errors[3] -= itp_running_sgm->block->totalsteps;
-				stepbits |= STEP3_MASK;
-				if (itp_running_sgm->block->dirbits & DIR3_MASK)
-				{
-					itp_rt_step_pos[3]--;
-				}
-				else
+				if (!itp_stepper_is_locked(3))
 				{
-					itp_rt_step_pos[3]++;
+					stepbits |= STEP3_MASK;
+					if (itp_running_sgm->block->dirbits & DIR3_MASK)
+					{
+						itp_rt_step_pos[3]--;
+					}
+					else
+					{
+						itp_rt_step_pos[3]++;
+					}
 				}
 			}
 #endif
@@ -723,14 +840,17 @@ void itp_step_isr()
 			if (itp_running_sgm->block->errors[4] > itp_running_sgm->block->totalsteps)
 			{
 				itp_running_sgm->block->errors[4] -= itp_running_sgm->block->totalsteps;
-				stepbits |= STEP4_MASK;
-				if (itp_running_sgm->block->dirbits & DIR4_MASK)
+				if (!itp_stepper_is_locked(4))
 				{
-					itp_rt_step_pos[4]--;
-				}
-				else
-				{
-					itp_rt_step_pos[4]++;
+					stepbits |= STEP4_MASK;
+					if (itp_running_sgm->block->dirbits & DIR4_MASK)
+					{
+						itp_rt_step_pos[4]--;
+					}
+					else
+					{
+						itp_rt_step_pos[4]++;
+					}
 				}
 			}
 #endif
@@ -739,14 +859,17 @@ void itp_step_isr()
 			if (itp_running_sgm->block->errors[5] > itp_running_sgm->block->totalsteps)
 			{
 				itp_running_sgm->block->errors[5] -= itp_running_sgm->block->totalsteps;
-				stepbits |= STEP5_MASK;
-				if (itp_running_sgm->block->dirbits & DIR5_MASK)
+				if (!itp_stepper_is_locked(5))
 				{
-					itp_rt_step_pos[5]--;
-				}
-				else
-				{
-					itp_rt_step_pos[5]++;
+					stepbits |= STEP5_MASK;
+					if (itp_running_sgm->block->dirbits & DIR5_MASK)
+					{
+						itp_rt_step_pos[5]--;
+					}
+					else
+					{
+						itp_rt_step_pos[5]++;
+					}
 				}
 			}
 #endif
@@ -768,6 +891,34 @@ void itp_step_isr()
 	//busy = false;
 }
 
+#ifdef ENABLE_CHECKMODE_SIMULATION
+void itp_sim_enable(bool enable)
+{
+	if (enable)
+	{
+		itp_sim_time = 0;
+		itp_sim_max_feed = 0;
+		itp_sim_stops = 0;
+	}
+	else if (itp_sim)
+	{
+		//simulates the remaining blocks in the planner
+		itp_sim_flush = true;
+		itp_run();
+		itp_sim_flush = false;
+	}
+
+	itp_sim = enable;
+}
+
+void itp_get_sim_stats(float *time, float *max_feed, uint16_t *stops)
+{
+	*time = itp_sim_time;
+	*max_feed = itp_sim_max_feed;
+	*stops = itp_sim_stops;
+}
+#endif
+
 void itp_delay(uint16_t delay)
 {
 	itp_sgm_data[itp_sgm_data_write].block = NULL;
@@ -776,5 +927,9 @@ void itp_delay(uint16_t delay)
 	itp_sgm_data[itp_sgm_data_write].remaining_steps = delay;
 	itp_sgm_data[itp_sgm_data_write].update_speed = true;
 	itp_sgm_data[itp_sgm_data_write].feed = 0;
+	#ifndef GCODE_IGNORE_LINE_NUMBERS
+	//dwell keeps the line number of the block being executed
+	itp_sgm_data[itp_sgm_data_write].linenum = (itp_cur_plan_block != NULL) ? itp_cur_plan_block->linenum : itp_rt_linenum;
+	#endif
 	itp_sgm_buffer_write();
 }
@@ -23,6 +23,9 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include "config.h"
+#include "machinedefs.h"
+
 void itp_init();
 void itp_run();
 void itp_update();
@@ -32,8 +35,18 @@ void itp_stop();
 void itp_clear();
 void itp_get_rt_position(float* axis);
 void itp_reset_rt_position();
+#ifdef KINEMATICS_STEPPER_LOCK
+void itp_lock_steppers(uint8_t lockmask);
+#endif
 float itp_get_rt_feed();
+#ifndef GCODE_IGNORE_LINE_NUMBERS
+uint32_t itp_get_rt_linenum();
+#endif
 float itp_get_rt_spindle();
 void itp_delay(uint16_t delay);
+#ifdef ENABLE_CHECKMODE_SIMULATION
+void itp_sim_enable(bool enable);
+void itp_get_sim_stats(float *time, float *max_feed, uint16_t *stops);
+#endif
 
 #endif
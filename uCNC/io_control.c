@@ -24,11 +24,22 @@
 #include "mcudefs.h"
 #include "mcu.h"
 #include "mcumap.h"
+#include "machinedefs.h"
 #include "io_control.h"
 #include "parser.h"
 #include "interpolator.h"
 #include "cnc.h"
 
+#ifdef KINEMATICS_STEPPER_LOCK
+//limit switches that stop their own stepper while homing
+static uint8_t io_lock_limits;
+
+void io_set_lock_limits(uint8_t limitmask)
+{
+	io_lock_limits = limitmask;
+}
+#endif
+
 void io_limits_isr(uint8_t limits)
 {	
 	limits ^= g_settings.limits_invert_mask;
@@ -37,6 +48,30 @@ void io_limits_isr(uint8_t limits)
 	{
 		if(limits)
 		{
+			#ifdef KINEMATICS_STEPPER_LOCK
+			if(io_lock_limits && cnc_get_exec_state(EXEC_HOMING))
+			{
+				//each triggered switch stops its stepper and the motion continues until all switches are triggered
+				uint8_t lockmask = 0;
+				if(limits & LIMIT_X_MASK)
+				{
+					lockmask |= 0x01;
+				}
+				if(limits & LIMIT_Y_MASK)
+				{
+					lockmask |= 0x02;
+				}
+				if(limits & LIMIT_Z_MASK)
+				{
+					lockmask |= 0x04;
+				}
+				itp_lock_steppers(lockmask);
+				if((limits & io_lock_limits) != io_lock_limits)
+				{
+					return;
+				}
+			}
+			#endif
 			if(cnc_get_exec_state(EXEC_RUN))
 			{
 				cnc_set_exec_state(EXEC_NOHOME); //if motions was executing flags home position lost
@@ -104,6 +139,13 @@ bool io_check_boundaries(float* axis)
 	for(uint8_t i = AXIS_COUNT; i!=0;)
 	{
 		i--;
+#ifdef AXIS_ROTARY
+		//the rotary axis turns freely
+		if(i == AXIS_ROTARY)
+		{
+			continue;
+		}
+#endif
 		float value = (axis[i] < 0) ? -axis[i] : axis[i];
 		if(value > g_settings.max_distance[i])
 		{
@@ -136,7 +178,7 @@ void io_disable_probe()
 
 bool io_get_probe()
 {
-	bool probe = (mcu_get_limits() & PROBE_MASK);
+	bool probe = mcu_get_probe();
 	return (!g_settings.probe_invert_mask) ? probe : !probe;
 }
 
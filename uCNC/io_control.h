@@ -26,6 +26,7 @@
 #define DIGITAL_IO_CONTROL_H
 
 #include <stdbool.h>
+#include "machinedefs.h"
 
 //ISR
 void io_limits_isr(uint8_t limits);
@@ -35,6 +36,9 @@ void io_probe_isr(uint8_t probe);
 //inputs
 bool io_check_boundaries(float* axis);
 uint8_t io_get_limits(uint8_t limitmask);
+#ifdef KINEMATICS_STEPPER_LOCK
+void io_set_lock_limits(uint8_t limitmask);
+#endif
 uint8_t io_get_controls(uint8_t controlmask);
 void io_enable_probe();
 void io_disable_probe();
@@ -37,6 +37,12 @@ void kinematics_apply_inverse(float* axis, uint32_t* steps);
 */
 void kinematics_apply_forward(uint32_t* steps, float* axis);
 
+/*
+	Converts the normalized motion direction to the direction in which the max feed and acceleration
+	settings of each axis are applied by the planner (the steppers direction in machines like coreXY)
+*/
+void kinematics_apply_inverse_dir(float* dir, float* limits_dir);
+
 /*
 	Executes the homing motion for the given kinematic
 */
@@ -22,6 +22,7 @@
 #if(MACHINE_KINEMATICS==MACHINE_CARTESIAN_XYZ)
 #include <stdio.h>
 #include <math.h>
+#include <string.h>
 #include "mcu.h"
 #include "settings.h"
 #include "kinematics.h"
@@ -34,16 +35,44 @@
 
 void kinematics_apply_inverse(float* axis, uint32_t* steps)
 {
-	steps[0] = (uint32_t)lroundf(g_settings.step_per_mm[0] * axis[AXIS_X]);
-	steps[1] = (uint32_t)lroundf(g_settings.step_per_mm[1] * axis[AXIS_Y]);
-	steps[2] = (uint32_t)lroundf(g_settings.step_per_mm[2] * axis[AXIS_Z]);
+#ifdef ENABLE_SKEW_COMPENSATION
+	//motors positions that move the tool to the target (corrects the measured skew and scale)
+	float x = g_settings_derived.skew_correction[0][0] * axis[AXIS_X] + g_settings_derived.skew_correction[0][1] * axis[AXIS_Y] + g_settings_derived.skew_correction[0][2] * axis[AXIS_Z];
+	float y = g_settings_derived.skew_correction[1][1] * axis[AXIS_Y] + g_settings_derived.skew_correction[1][2] * axis[AXIS_Z];
+	float z = g_settings_derived.skew_correction[2][2] * axis[AXIS_Z];
+#else
+	float x = axis[AXIS_X];
+	float y = axis[AXIS_Y];
+	float z = axis[AXIS_Z];
+#endif
+	steps[0] = (uint32_t)lroundf(g_settings.step_per_mm[0] * x);
+	steps[1] = (uint32_t)lroundf(g_settings.step_per_mm[1] * y);
+	steps[2] = (uint32_t)lroundf(g_settings.step_per_mm[2] * z);
+#ifdef AXIS_A
+	steps[3] = (uint32_t)lroundf(g_settings.step_per_mm[3] * axis[AXIS_A]);
+#endif
 }
 
 void kinematics_apply_forward(uint32_t* steps, float* axis)
 {
-	axis[AXIS_X] = (float)(((int32_t)steps[0]) / g_settings.step_per_mm[0]);
-	axis[AXIS_Y] = (float)(((int32_t)steps[1]) / g_settings.step_per_mm[1]);
-	axis[AXIS_Z] = (float)(((int32_t)steps[2]) / g_settings.step_per_mm[2]);
+	axis[AXIS_X] = (float)(((int32_t)steps[0]) * g_settings_derived.mm_per_step[0]);
+	axis[AXIS_Y] = (float)(((int32_t)steps[1]) * g_settings_derived.mm_per_step[1]);
+	axis[AXIS_Z] = (float)(((int32_t)steps[2]) * g_settings_derived.mm_per_step[2]);
+#ifdef ENABLE_SKEW_COMPENSATION
+	//the tool position is the motors position with the measured skew and scale errors
+	axis[AXIS_X] = g_settings.axis_scale[0] * axis[AXIS_X] + g_settings.skew_factor[0] * axis[AXIS_Y] + g_settings.skew_factor[1] * axis[AXIS_Z];
+	axis[AXIS_Y] = g_settings.axis_scale[1] * axis[AXIS_Y] + g_settings.skew_factor[2] * axis[AXIS_Z];
+	axis[AXIS_Z] = g_settings.axis_scale[2] * axis[AXIS_Z];
+#endif
+#ifdef AXIS_A
+	axis[AXIS_A] = (float)(((int32_t)steps[3]) * g_settings_derived.mm_per_step[3]);
+#endif
+}
+
+void kinematics_apply_inverse_dir(float* dir, float* limits_dir)
+{
+	//the limits are applied to each axis
+	memcpy(limits_dir, dir, sizeof(float) * AXIS_COUNT);
 }
 
 uint8_t kinematics_home()
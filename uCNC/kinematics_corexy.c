@@ -20,27 +20,62 @@
 
 #if(MACHINE_KINEMATICS==MACHINE_COREXY)
 #include <stdio.h>
+#include <math.h>
 #include "mcu.h"
 #include "settings.h"
 #include "kinematics.h"
 #include "machinedefs.h"
+#include "motion_control.h"
+#include "grbl_interface.h"
 
+/*
+	The X and Y steppers are the A and B motors of the coreXY belts
+	A = X + Y and B = X - Y (the step per mm, max feed and acceleration settings of X and Y are the motors settings)
+*/
 void kinematics_apply_inverse(float* axis, uint32_t* steps)
 {
-	steps[0] = (uint32_t)lroundf(g_settings.step_mm[0] * (axis[AXIS_X] + axis[AXIS_Y]));
-	steps[1] = (uint32_t)lroundf(g_settings.step_mm[1] * (axis[AXIS_X] - axis[AXIS_Y]));
-	steps[2] = (uint32_t)lroundf(g_settings.step_mm[2] * axis[AXIS_Z]);
+#ifdef ENABLE_SKEW_COMPENSATION
+	//gantry positions that move the tool to the target (corrects the measured skew and scale)
+	float x = g_settings_derived.skew_correction[0][0] * axis[AXIS_X] + g_settings_derived.skew_correction[0][1] * axis[AXIS_Y] + g_settings_derived.skew_correction[0][2] * axis[AXIS_Z];
+	float y = g_settings_derived.skew_correction[1][1] * axis[AXIS_Y] + g_settings_derived.skew_correction[1][2] * axis[AXIS_Z];
+	float z = g_settings_derived.skew_correction[2][2] * axis[AXIS_Z];
+#else
+	float x = axis[AXIS_X];
+	float y = axis[AXIS_Y];
+	float z = axis[AXIS_Z];
+#endif
+	steps[0] = (uint32_t)lroundf(g_settings.step_per_mm[0] * (x + y));
+	steps[1] = (uint32_t)lroundf(g_settings.step_per_mm[1] * (x - y));
+	steps[2] = (uint32_t)lroundf(g_settings.step_per_mm[2] * z);
 }
 
 void kinematics_apply_forward(uint32_t* steps, float* axis)
 {
-	axis[AXIS_X] = (float)(step_mm_inv[0] * 0.5f * (steps[0] + steps[1]));
-	axis[AXIS_Y] = (float)(step_mm_inv[1] * 0.5f * (steps[0] - steps[1]));
-	axis[AXIS_Z] = (float)(step_mm_inv[2] * steps[2]);
+	float a = ((int32_t)steps[0]) * g_settings_derived.mm_per_step[0];
+	float b = ((int32_t)steps[1]) * g_settings_derived.mm_per_step[1];
+	axis[AXIS_X] = 0.5f * (a + b);
+	axis[AXIS_Y] = 0.5f * (a - b);
+	axis[AXIS_Z] = ((int32_t)steps[2]) * g_settings_derived.mm_per_step[2];
+#ifdef ENABLE_SKEW_COMPENSATION
+	//the tool position is the gantry position with the measured skew and scale errors
+	axis[AXIS_X] = g_settings.axis_scale[0] * axis[AXIS_X] + g_settings.skew_factor[0] * axis[AXIS_Y] + g_settings.skew_factor[1] * axis[AXIS_Z];
+	axis[AXIS_Y] = g_settings.axis_scale[1] * axis[AXIS_Y] + g_settings.skew_factor[2] * axis[AXIS_Z];
+	axis[AXIS_Z] = g_settings.axis_scale[2] * axis[AXIS_Z];
+#endif
+}
+
+void kinematics_apply_inverse_dir(float* dir, float* limits_dir)
+{
+	//the max feed and acceleration are the limits of the motors
+	//a diagonal motion only runs one of the motors (at a speed of sqrt(2) times the motion speed)
+	limits_dir[0] = dir[AXIS_X] + dir[AXIS_Y];
+	limits_dir[1] = dir[AXIS_X] - dir[AXIS_Y];
+	limits_dir[2] = dir[AXIS_Z];
 }
 
-void kinematics_home()
+uint8_t kinematics_home()
 {
+	//the homing motion of X or Y is a machine space motion (runs both motors)
 	uint8_t result = 0;
 	result = mc_home_axis(AXIS_Z, LIMIT_Z_MASK);
 	if(result != 0)
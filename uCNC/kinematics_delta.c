@@ -0,0 +1,153 @@
+/*
+	Name: kinematics_delta.c
+	Description: Implements all kinematics math equations to translate the motion of a linear delta machine.
+		Also implements the homing motion for this type of machine.
+		The towers are placed at 210, 330 and 90 degrees (X, Y and Z steppers) and the tower positions and
+		squared arm length are computed once when the settings change (settings $28 and $29).
+		The machine X and Y coordinates are centered in the middle of the towers.
+
+	Copyright: Copyright (c) João Martins
+	Author: João Martins
+	Date: 19/10/2026
+
+	uCNC is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version. Please see <http://www.gnu.org/licenses/>
+
+	uCNC is distributed WITHOUT ANY WARRANTY;
+	Also without the implied warranty of	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+	See the	GNU General Public License for more details.
+*/
+
+#include "config.h"
+
+#if(MACHINE_KINEMATICS==MACHINE_DELTA)
+#include <math.h>
+#include <string.h>
+#include "mcu.h"
+#include "settings.h"
+#include "kinematics.h"
+#include "machinedefs.h"
+#include "io_control.h"
+#include "planner.h"
+#include "motion_control.h"
+#include "grbl_interface.h"
+
+#define LIMITS_DELTA_MASK (LIMIT_X_MASK | LIMIT_Y_MASK | LIMIT_Z_MASK)
+
+//carriages height at the zero step position (set by the homing so that all carriages are at the same height at the switches)
+static float delta_carriage_origin[STEPPER_COUNT];
+
+void kinematics_apply_inverse(float* axis, uint32_t* steps)
+{
+	//carriage height = z + sqrt(arm^2 - (x - tower_x)^2 - (y - tower_y)^2)
+	for(uint8_t i = 0; i < STEPPER_COUNT; i++)
+	{
+		float dx = axis[AXIS_X] - g_settings_derived.delta_tower_x[i];
+		float dy = axis[AXIS_Y] - g_settings_derived.delta_tower_y[i];
+		float height = g_settings_derived.delta_arm_sqr - dx * dx - dy * dy;
+		//unreachable positions are clamped to the arm in the horizontal position
+		height = (height > 0) ? sqrtf(height) : 0;
+		steps[i] = (uint32_t)lroundf(g_settings.step_per_mm[i] * (axis[AXIS_Z] + height - delta_carriage_origin[i]));
+	}
+}
+
+void kinematics_apply_forward(uint32_t* steps, float* axis)
+{
+	/*
+		trilateration of the effector position (intersection of the three spheres with the radius of the arm length centered at each carriage)
+		builds an orthonormal base (ex, ey, ez) with the origin in the first carriage
+	*/
+	float z1 = ((int32_t)steps[0]) * g_settings_derived.mm_per_step[0] + delta_carriage_origin[0];
+	float z2 = ((int32_t)steps[1]) * g_settings_derived.mm_per_step[1] + delta_carriage_origin[1];
+	float z3 = ((int32_t)steps[2]) * g_settings_derived.mm_per_step[2] + delta_carriage_origin[2];
+
+	float p12[3];
+	p12[0] = g_settings_derived.delta_tower_x[1] - g_settings_derived.delta_tower_x[0];
+	p12[1] = g_settings_derived.delta_tower_y[1] - g_settings_derived.delta_tower_y[0];
+	p12[2] = z2 - z1;
+	float p13[3];
+	p13[0] = g_settings_derived.delta_tower_x[2] - g_settings_derived.delta_tower_x[0];
+	p13[1] = g_settings_derived.delta_tower_y[2] - g_settings_derived.delta_tower_y[0];
+	p13[2] = z3 - z1;
+
+	float d = sqrtf(p12[0] * p12[0] + p12[1] * p12[1] + p12[2] * p12[2]);
+	float d_inv = 1.0f / d;
+	float ex[3];
+	float ey[3];
+	float ez[3];
+	float i = 0;
+	for(uint8_t k = 0; k < 3; k++)
+	{
+		ex[k] = p12[k] * d_inv;
+		i += ex[k] * p13[k];
+	}
+
+	float j = 0;
+	for(uint8_t k = 0; k < 3; k++)
+	{
+		ey[k] = p13[k] - i * ex[k];
+		j += ey[k] * ey[k];
+	}
+
+	j = sqrtf(j);
+	float j_inv = 1.0f / j;
+	for(uint8_t k = 0; k < 3; k++)
+	{
+		ey[k] *= j_inv;
+	}
+
+	ez[0] = ex[1] * ey[2] - ex[2] * ey[1];
+	ez[1] = ex[2] * ey[0] - ex[0] * ey[2];
+	ez[2] = ex[0] * ey[1] - ex[1] * ey[0];
+
+	//position in the new base (the effector is below the carriages)
+	float x = 0.5f * d;
+	float y = ((i * i + j * j) * 0.5f - i * x) * j_inv;
+	float z = g_settings_derived.delta_arm_sqr - x * x - y * y;
+	z = (z > 0) ? sqrtf(z) : 0;
+
+	axis[AXIS_X] = g_settings_derived.delta_tower_x[0] + ex[0] * x + ey[0] * y - ez[0] * z;
+	axis[AXIS_Y] = g_settings_derived.delta_tower_y[0] + ex[1] * x + ey[1] * y - ez[1] * z;
+	axis[AXIS_Z] = z1 + ex[2] * x + ey[2] * y - ez[2] * z;
+}
+
+void kinematics_apply_inverse_dir(float* dir, float* limits_dir)
+{
+	//the limits are applied in the machine space (the towers speed changes along the motion)
+	memcpy(limits_dir, dir, sizeof(float) * AXIS_COUNT);
+}
+
+uint8_t kinematics_home()
+{
+	/*
+		a Z motion moves the three carriages together to the top of the towers and each carriage stops at its own switch
+		the motion ends when all the switches are triggered and the released switches set the same height for all carriages
+		(X and Y are at the center of the towers)
+		the homing direction of Z must be set to positive ($23 Z bit set) to home to the top
+	*/
+	io_set_lock_limits(LIMITS_DELTA_MASK);
+	uint8_t result = mc_home_axis(AXIS_Z, LIMITS_DELTA_MASK);
+	io_set_lock_limits(0);
+	if(result != 0)
+	{
+		return result;
+	}
+
+	float position[AXIS_COUNT];
+	uint32_t steps[STEPPER_COUNT];
+	planner_resync_position();
+	planner_get_position(position);
+	kinematics_apply_inverse(position, steps);
+	for(uint8_t i = 0; i < STEPPER_COUNT; i++)
+	{
+		delta_carriage_origin[i] = -((int32_t)steps[i]) * g_settings_derived.mm_per_step[i];
+	}
+
+	planner_resync_position();
+	mc_resync_position();
+	return STATUS_OK;
+}
+
+#endif
@@ -0,0 +1,238 @@
+/*
+	Name: kinematics_scara.c
+	Description: Implements all kinematics math equations to translate the motion of a two link SCARA arm.
+		Also implements the homing motion for this type of machine.
+		The shoulder joint (X stepper) is at the machine origin and the elbow joint (Y stepper) is at the end of the
+		upper arm ($28). The forearm length is $29. The Z stepper moves the tool linearly.
+		The joint angles are in degrees ($100 and $101 are in steps per degree). The shoulder angle is measured
+		from the X axis and the elbow angle from the upper arm direction (the elbow always bends counterclockwise).
+		The shoulder range is -180 to 180 degrees so the work area must not cross the negative X axis.
+		The trigonometric functions are computed from small tables in ROM. The table value at the nearest
+		point is corrected with the angle addition formulas so the result has the precision of a float.
+
+	Copyright: Copyright (c) João Martins
+	Author: João Martins
+	Date: 19/10/2026
+
+	uCNC is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version. Please see <http://www.gnu.org/licenses/>
+
+	uCNC is distributed WITHOUT ANY WARRANTY;
+	Also without the implied warranty of	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+	See the	GNU General Public License for more details.
+*/
+
+#include "config.h"
+
+#if(MACHINE_KINEMATICS==MACHINE_SCARA)
+#include <math.h>
+#include <string.h>
+#include <stdbool.h>
+#include "mcu.h"
+#include "settings.h"
+#include "kinematics.h"
+#include "machinedefs.h"
+#include "planner.h"
+#include "motion_control.h"
+#include "grbl_interface.h"
+
+#define SCARA_TABLE_BITS 5
+#define SCARA_TABLE_SIZE (1 << SCARA_TABLE_BITS)
+#define SCARA_PI 3.14159265f
+#define SCARA_PI_2 1.57079633f
+#define SCARA_DEG_RAD 0.0174532925f
+#define SCARA_RAD_DEG 57.2957795f
+
+//atan(i / 32) for i = 0 to 32
+static const float __rom__ scara_atan_table[SCARA_TABLE_SIZE + 1] = {
+	0.000000000f, 0.031239833f, 0.062418810f, 0.093476781f, 0.124354995f, 0.154996742f, 0.185347950f, 0.215357700f,
+	0.244978663f, 0.274167451f, 0.302884868f, 0.331096077f, 0.358770670f, 0.385882669f, 0.412410442f, 0.438336560f,
+	0.463647609f, 0.488333951f, 0.512389460f, 0.535811238f, 0.558599315f, 0.580756354f, 0.602287346f, 0.623199330f,
+	0.643501109f, 0.663202993f, 0.682316555f, 0.700854408f, 0.718830000f, 0.736257429f, 0.753151281f, 0.769526480f,
+	0.785398163f
+};
+
+//sin(i * pi / 64) for i = 0 to 32 (a quarter of a turn)
+static const float __rom__ scara_sin_table[SCARA_TABLE_SIZE + 1] = {
+	0.000000000f, 0.049067674f, 0.098017140f, 0.146730474f, 0.195090322f, 0.242980180f, 0.290284677f, 0.336889853f,
+	0.382683432f, 0.427555093f, 0.471396737f, 0.514102744f, 0.555570233f, 0.595699304f, 0.634393284f, 0.671558955f,
+	0.707106781f, 0.740951125f, 0.773010453f, 0.803207531f, 0.831469612f, 0.857728610f, 0.881921264f, 0.903989293f,
+	0.923879533f, 0.941544065f, 0.956940336f, 0.970031253f, 0.980785280f, 0.989176510f, 0.995184727f, 0.998795456f,
+	1.000000000f
+};
+
+//angle of each joint at step position 0 (set by the homing cycle)
+static float scara_joint_origin[2];
+//while homing the X and Y axis are the joint angles
+static bool scara_joint_mode;
+
+static float scara_table_read(const float* ptr)
+{
+	float value;
+	rom_memcpy(&value, ptr, sizeof(float));
+	return value;
+}
+
+static float scara_atan2(float y, float x)
+{
+	float ax = fabsf(x);
+	float ay = fabsf(y);
+	if (ax == 0 && ay == 0)
+	{
+		return 0;
+	}
+
+	//reduces to the first octant (0 <= t <= 1)
+	bool swap = (ay > ax);
+	float t = swap ? (ax / ay) : (ay / ax);
+	uint8_t i = (uint8_t)(t * SCARA_TABLE_SIZE + 0.5f);
+	float t0 = i * (1.0f / SCARA_TABLE_SIZE);
+	//atan(t) = atan(t0) + atan(u) with u = (t - t0) / (1 + t * t0) and |u| <= 1/64
+	float u = (t - t0) / (1 + t * t0);
+	float angle = scara_table_read(&scara_atan_table[i]) + u - u * u * u * (1.0f / 3.0f);
+
+	angle = swap ? (SCARA_PI_2 - angle) : angle;
+	angle = (x < 0) ? (SCARA_PI - angle) : angle;
+	return (y < 0) ? -angle : angle;
+}
+
+static void scara_sincos(float angle, float* s, float* c)
+{
+	//nearest table point (in steps of pi/64) and the remaining angle (|d| <= pi/128)
+	int32_t k = lroundf(angle * (2 * SCARA_TABLE_SIZE / SCARA_PI));
+	float d = angle - k * (SCARA_PI / (2 * SCARA_TABLE_SIZE));
+	uint8_t j = (uint8_t)(k & (SCARA_TABLE_SIZE - 1));
+	uint8_t quadrant = (uint8_t)((k >> SCARA_TABLE_BITS) & 0x03);
+	float sin_k = scara_table_read(&scara_sin_table[j]);
+	float cos_k = scara_table_read(&scara_sin_table[SCARA_TABLE_SIZE - j]);
+	float tmp;
+	switch (quadrant)
+	{
+	case 1:
+		tmp = sin_k;
+		sin_k = cos_k;
+		cos_k = -tmp;
+		break;
+	case 2:
+		sin_k = -sin_k;
+		cos_k = -cos_k;
+		break;
+	case 3:
+		tmp = sin_k;
+		sin_k = -cos_k;
+		cos_k = tmp;
+		break;
+	}
+
+	//angle addition with the Taylor series of the remaining angle
+	float d2 = d * d;
+	float sin_d = d * (1 - d2 * (1.0f / 6.0f));
+	float cos_d = 1 - d2 * (0.5f - d2 * (1.0f / 24.0f));
+	*s = sin_k * cos_d + cos_k * sin_d;
+	*c = cos_k * cos_d - sin_k * sin_d;
+}
+
+void kinematics_apply_inverse(float* axis, uint32_t* steps)
+{
+	float joint[2];
+	if (scara_joint_mode)
+	{
+		joint[0] = axis[AXIS_X];
+		joint[1] = axis[AXIS_Y];
+	}
+	else
+	{
+		//elbow angle from the law of cosines (unreachable positions are clamped to the arm limits)
+		float x = axis[AXIS_X];
+		float y = axis[AXIS_Y];
+		float c2 = (x * x + y * y - g_settings_derived.scara_arm_sqr_sum) * g_settings_derived.scara_cos_scale;
+		c2 = (c2 < 1) ? c2 : 1;
+		c2 = (c2 > -1) ? c2 : -1;
+		float s2 = sqrtf(1 - c2 * c2);
+		joint[1] = scara_atan2(s2, c2) * SCARA_RAD_DEG;
+		joint[0] = (scara_atan2(y, x) - scara_atan2(g_settings.scara_arm_length[1] * s2, g_settings.scara_arm_length[0] + g_settings.scara_arm_length[1] * c2)) * SCARA_RAD_DEG;
+	}
+
+	steps[0] = (uint32_t)lroundf(g_settings.step_per_mm[0] * (joint[0] - scara_joint_origin[0]));
+	steps[1] = (uint32_t)lroundf(g_settings.step_per_mm[1] * (joint[1] - scara_joint_origin[1]));
+	steps[2] = (uint32_t)lroundf(g_settings.step_per_mm[2] * axis[AXIS_Z]);
+}
+
+void kinematics_apply_forward(uint32_t* steps, float* axis)
+{
+	float joint0 = ((int32_t)steps[0]) * g_settings_derived.mm_per_step[0] + scara_joint_origin[0];
+	float joint1 = ((int32_t)steps[1]) * g_settings_derived.mm_per_step[1] + scara_joint_origin[1];
+	axis[AXIS_Z] = ((int32_t)steps[2]) * g_settings_derived.mm_per_step[2];
+
+	if (scara_joint_mode)
+	{
+		axis[AXIS_X] = joint0;
+		axis[AXIS_Y] = joint1;
+		return;
+	}
+
+	float s1, c1, s12, c12;
+	scara_sincos(joint0 * SCARA_DEG_RAD, &s1, &c1);
+	scara_sincos((joint0 + joint1) * SCARA_DEG_RAD, &s12, &c12);
+	axis[AXIS_X] = g_settings.scara_arm_length[0] * c1 + g_settings.scara_arm_length[1] * c12;
+	axis[AXIS_Y] = g_settings.scara_arm_length[0] * s1 + g_settings.scara_arm_length[1] * s12;
+}
+
+void kinematics_apply_inverse_dir(float* dir, float* limits_dir)
+{
+	//the limits are applied in the machine space (the joints speed changes along the motion)
+	memcpy(limits_dir, dir, sizeof(float) * AXIS_COUNT);
+}
+
+//homes a joint (the X and Y axis are the joint angles) and sets the joint angle at the switch to the home angle
+static uint8_t scara_home_joint(uint8_t joint, uint8_t axis_limit)
+{
+	uint8_t result = mc_home_axis(joint, axis_limit);
+	if (result != 0)
+	{
+		return result;
+	}
+
+	float position[AXIS_COUNT];
+	planner_resync_position();
+	planner_get_position(position);
+	scara_joint_origin[joint] += g_settings.scara_home_angle[joint] - position[joint];
+	planner_resync_position();
+	return STATUS_OK;
+}
+
+uint8_t kinematics_home()
+{
+	/*
+		the joints move one at a time so the homing motions are done in the joint space
+		each joint searches the switch over 1.5 times the max distance of the axis ($130 and $131) in degrees
+		the joint angles at the switches are set by $36 and $37
+	*/
+	uint8_t result = mc_home_axis(AXIS_Z, LIMIT_Z_MASK);
+	if (result != 0)
+	{
+		return result;
+	}
+
+	scara_joint_mode = true;
+	planner_resync_position();
+	result = scara_home_joint(AXIS_X, LIMIT_X_MASK);
+	if (result == 0)
+	{
+		result = scara_home_joint(AXIS_Y, LIMIT_Y_MASK);
+	}
+
+	scara_joint_mode = false;
+	planner_resync_position();
+	mc_resync_position();
+	if (result != 0)
+	{
+		return result;
+	}
+
+	return STATUS_OK;
+}
+
+#endif
@@ -27,19 +27,66 @@
 
 //define kynematics
 #if (MACHINE_KINEMATICS == MACHINE_CARTESIAN_XYZ)
-	#define AXIS_COUNT 3
 	#define AXIS_X 0
 	#define AXIS_Y 1
 	#define AXIS_Z 2
+	#ifdef ENABLE_ROTARY_AXIS_A
+	#define AXIS_COUNT 4
+	#define AXIS_A 3
+	#define STEPPER_COUNT 4
+	//A is in degrees and wraps at 360
+	#define AXIS_ROTARY AXIS_A
+	#else
+	#define AXIS_COUNT 3
 	#define STEPPER_COUNT 3
+	#endif
+	#define HOMING_AXIS_MASK 0x07
 #elif (MACHINE_KINEMATICS == MACHINE_COREXY)
 	#define AXIS_COUNT 3
 	#define AXIS_X 0
 	#define AXIS_Y 1
 	#define AXIS_Z 2
 	#define STEPPER_COUNT 3	
+	#define HOMING_AXIS_MASK 0x07
+#elif (MACHINE_KINEMATICS == MACHINE_DELTA)
+	#define AXIS_COUNT 3
+	#define AXIS_X 0
+	#define AXIS_Y 1
+	#define AXIS_Z 2
+	#define STEPPER_COUNT 3
+	//only Z has a home position (the carriages home to the top of the towers with X and Y at the center)
+	#define HOMING_AXIS_MASK 0x04
+	//straight lines are curved in the steppers space (the motion control splits lines in segments)
+	#define KINEMATICS_NONLINEAR
+	//each carriage stops at its own tower switch while homing
+	#define KINEMATICS_STEPPER_LOCK
+#elif (MACHINE_KINEMATICS == MACHINE_SCARA)
+	#define AXIS_COUNT 3
+	#define AXIS_X 0
+	#define AXIS_Y 1
+	#define AXIS_Z 2
+	#define STEPPER_COUNT 3
+	//only Z has a home position (the joints home to the angles set in the settings)
+	#define HOMING_AXIS_MASK 0x04
+	//straight lines are curved in the joints space (the motion control splits lines in segments)
+	#define KINEMATICS_NONLINEAR
 #else
 #error Kinematics not implemented
 #endif
 
+#if(defined(ENABLE_ROTARY_AXIS_A) && !defined(AXIS_A))
+#error "The rotary A axis is only available on cartesian machines"
+#endif
+
+#if(defined(ENABLE_SKEW_COMPENSATION) && MACHINE_KINEMATICS != MACHINE_CARTESIAN_XYZ && MACHINE_KINEMATICS != MACHINE_COREXY)
+#error "The skew compensation is only available on cartesian and coreXY machines"
+#endif
+
+/*
+	HOMING_AXIS_MASK sets the axis that have a home position (the homing offset pull-off and the
+	origin set after homing only apply to these axis). All other axis keep the position set by the kinematics homing.
+	KINEMATICS_STEPPER_LOCK makes each of the X, Y and Z limit switches stop only its own stepper (0, 1 and 2) while homing.
+	The homing motion only stops when all the homing switches are triggered.
+*/
+
 #endif
@@ -21,5 +21,7 @@
 
 #define MACHINE_CARTESIAN_XYZ 1
 #define MACHINE_COREXY 2
+#define MACHINE_DELTA 3
+#define MACHINE_SCARA 4
 
 #endif
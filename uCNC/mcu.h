@@ -68,7 +68,7 @@ static inline uint8_t mcu_get_limits()
 static inline bool mcu_get_probe()
 {
 	#ifdef PROBE_INREG
-	return (PROBE_INREG && PROBE_MASK);
+	return (PROBE_INREG & PROBE_MASK);
 	#else
 	return false;
 	#endif
@@ -158,12 +158,25 @@ void mcu_change_step_ISR(uint16_t ticks, uint8_t prescaller);
 //stops the pulse 
 void mcu_step_stop_ISR();
 
+//System tick
+//returns the elapsed time since startup in milliseconds
+uint32_t mcu_millis();
+
 //Custom delay function
 //void mcu_delay_ms(uint16_t miliseconds);
 
 //Non volatile memory
-uint8_t mcu_eeprom_getc(uint16_t address);
-uint8_t mcu_eeprom_putc(uint16_t address, uint8_t value);
+//block read and write (only the bytes that change are written)
+void mcu_eeprom_read(uint16_t address, uint8_t* buffer, uint16_t len);
+void mcu_eeprom_write(uint16_t address, const uint8_t* buffer, uint16_t len);
+
+#ifdef ENABLE_PROGRAM_STORAGE
+//Program storage (block device)
+//opens the stored program and returns its size in bytes (0 if there is no storage device or program)
+uint32_t mcu_storage_open();
+//reads up to len bytes of the stored program starting at offset to the buffer and returns the number of bytes read
+uint16_t mcu_storage_read(uint32_t offset, uint8_t* buffer, uint16_t len);
+#endif
 
 /*
 #ifdef __PERFSTATS__
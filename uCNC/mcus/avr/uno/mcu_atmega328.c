@@ -70,6 +70,9 @@
 /*int mcu_putchar(char c, FILE* stream);
 FILE g_mcu_streamout = FDEV_SETUP_STREAM(mcu_putchar, NULL, _FDEV_SETUP_WRITE);*/
 
+//system tick counter (1ms)
+volatile static uint32_t mcu_runtime_ms;
+
 #ifdef __PERFSTATS__
 volatile uint16_t mcu_perf_step;
 volatile uint16_t mcu_perf_step_reset;
@@ -86,6 +89,11 @@ uint16_t mcu_get_step_reset_clocks()
 }
 #endif
 
+ISR(TIMER0_COMPA_vect, ISR_BLOCK)
+{
+	mcu_runtime_ms++;
+}
+
 ISR(TIMER1_COMPA_vect, ISR_BLOCK)
 {
 	#ifdef __PERFSTATS__
@@ -380,6 +388,14 @@ void mcu_init()
 		PWM3_CNTREG = 0;
 	#endif
 
+	//System tick
+	//TIMER0 in CTC mode with prescaller 1/64 generates an ISR every 1ms
+	TCCR0A = (1 << WGM01);
+	TCCR0B = (1 << CS01) | (1 << CS00);
+	OCR0A = (uint8_t)((F_CPU / 64000UL) - 1);
+	TCNT0 = 0;
+	TIMSK0 |= (1 << OCIE0A);
+
     // Set baud rate
     #if BAUD < 57600
       uint16_t UBRR0_value = ((F_CPU / (8L * BAUD)) - 1)/2 ;
@@ -754,6 +770,16 @@ void mcu_step_stop_ISR()
     TIMSK1 &= ~((1 << OCIE1B) | (1 << OCIE1A));
 }
 
+uint32_t mcu_millis()
+{
+	//reads the 32bit counter atomically
+	uint8_t sreg = SREG;
+	cli();
+	uint32_t val = mcu_runtime_ms;
+	SREG = sreg;
+	return val;
+}
+
 /*#define MCU_1MS_LOOP F_CPU/1000000
 static __attribute__((always_inline)) void mcu_delay_1ms() 
 {
@@ -779,7 +805,7 @@ void mcu_delay_ms(uint16_t miliseconds)
 #define EEPM1 5 //!< EEPROM Programming Mode Bit 1.
 #define EEPM0 4 //!< EEPROM Programming Mode Bit 0.
 
-uint8_t mcu_eeprom_getc(uint16_t address)
+static uint8_t mcu_eeprom_getc(uint16_t address)
 {
 	do {} while( EECR & (1<<EEPE) ); // Wait for completion of previous write.
 	EEAR = address; // Set EEPROM address register.
@@ -788,7 +814,7 @@ uint8_t mcu_eeprom_getc(uint16_t address)
 }
 
 //taken from grbl
-uint8_t mcu_eeprom_putc(uint16_t address, uint8_t value)
+static uint8_t mcu_eeprom_putc(uint16_t address, uint8_t value)
 {
 	char old_value; // Old EEPROM value.
 	char diff_mask; // Difference mask, i.e. old value XOR new value.
@@ -839,4 +865,21 @@ uint8_t mcu_eeprom_putc(uint16_t address, uint8_t value)
 	sei(); // Restore interrupt flag state.
 }
 
+void mcu_eeprom_read(uint16_t address, uint8_t* buffer, uint16_t len)
+{
+	for(; len != 0; len--)
+	{
+		*buffer++ = mcu_eeprom_getc(address++);
+	}
+}
+
+void mcu_eeprom_write(uint16_t address, const uint8_t* buffer, uint16_t len)
+{
+	//mcu_eeprom_putc only erases or programs the bits that change
+	for(; len != 0; len--)
+	{
+		mcu_eeprom_putc(address++, *buffer++);
+	}
+}
+
 #endif
@@ -36,6 +36,10 @@
 #define rom_memcpy memcpy_P
 #define rom_read_byte pgm_read_byte
 #define NOP _NOP
+//eeprom size in bytes
+#define EEPROM_SIZE 1024
+//motion control queue (saves RAM)
+#define MC_BUFFER_SIZE 2
 //used by the parser
 //this method is faster then normal multiplication (for 32 bit for 16 and 8 bits is slightly lower)
 #define fast_mult10(X) ((((X)<<2) + (X))<<1)
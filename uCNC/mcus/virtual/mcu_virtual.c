@@ -42,6 +42,11 @@
 #include <stdbool.h>
 #include <pthread.h> 
 #include <math.h>
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
 
 #include "../../settings.h"
 #include "virtualtimer.h"
@@ -67,6 +72,8 @@ virtports_t virtualports;
 static VIRTUAL_MAP virtualmap;
 /**/
 
+static void mcu_eeprom_open();
+
 //UART communication
 uint8_t g_mcu_combuffer[COM_BUFFER_SIZE];
 uint8_t g_mcu_bufferhead;
@@ -95,6 +102,7 @@ volatile unsigned long pulse_counter = 0;
 volatile unsigned long *pulse_counter_ptr;
 volatile unsigned long integrator_counter = 0;
 volatile bool send_char = false;
+volatile uint32_t mcu_runtime_ms = 0;
 
 pthread_t thread_id;
 pthread_t thread_idout;
@@ -178,6 +186,8 @@ void ticksimul()
 	static uint16_t tick_counter = 0;
 	static VIRTUAL_MAP initials = {};
 	
+	mcu_runtime_ms++;
+	
 	FILE *infile = fopen("inputs.txt", "r");
 	char inputs[255];
 	
@@ -239,6 +249,7 @@ void mcu_init()
 			printf("Failed to open input file");
 		}
 	}
+	mcu_eeprom_open();
 	g_cpu_freq = getCPUFreq();
 	#ifndef USECONSOLE
 	virtualserial_open();
@@ -375,6 +386,11 @@ void mcu_step_stop_ISR()
 	pulse_enabled = false;
 }
 
+uint32_t mcu_millis()
+{
+	return mcu_runtime_ms;
+}
+
 void mcu_delay_ms(uint16_t miliseconds)
 {
 }
@@ -405,59 +421,129 @@ void mcu_loadDummyPayload(const char* __fmt, ...)
 	g_mcu_buffercount++;
 }
 
-uint8_t mcu_eeprom_getc(uint16_t address)
+//the eeprom is a file mapped to memory (opened once in mcu_init)
+//if the file can't be mapped a RAM buffer is used instead (settings are lost on exit)
+static uint8_t virtual_eeprom_ram[EEPROM_SIZE];
+static uint8_t* virtual_eeprom = virtual_eeprom_ram;
+#ifdef __linux__
+static void mcu_eeprom_open()
 {
-	FILE* fp = fopen("virtualeeprom", "r");
-	uint8_t c = 0;
+	int fd = open("virtualeeprom", O_RDWR | O_CREAT, 0644);
+	if(fd < 0)
+	{
+		return;
+	}
 	
-	if(fp!=NULL)
+	if(!ftruncate(fd, EEPROM_SIZE))
 	{
-		if(!fseek(fp, address, SEEK_SET))
+		void* map = mmap(NULL, EEPROM_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		if(map != MAP_FAILED)
 		{
-			c = getc(fp);
-			fclose(fp);
+			virtual_eeprom = (uint8_t*)map;
 		}
-		
 	}
 	
-	return c;
+	//the mapping stays valid after closing the file
+	close(fd);
 }
 
-uint8_t mcu_eeprom_putc(uint16_t address, uint8_t value)
+static void mcu_eeprom_sync()
+{
+	if(virtual_eeprom != virtual_eeprom_ram)
+	{
+		msync(virtual_eeprom, EEPROM_SIZE, MS_SYNC);
+	}
+}
+#else
+static void mcu_eeprom_open()
 {
-	FILE* src = fopen("virtualeeprom", "r");
-	FILE* dest = fopen("newvirtualeeprom", "w");
+	HANDLE file = CreateFileA("virtualeeprom", GENERIC_READ | GENERIC_WRITE, 0, NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+	if(file == INVALID_HANDLE_VALUE)
+	{
+		return;
+	}
 	
-	for(int i = 0; i < address; i++)
+	//the mapping grows the file to the eeprom size
+	HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READWRITE, 0, EEPROM_SIZE, NULL);
+	if(mapping != NULL)
 	{
-		if(src!=NULL)
-			putc(getc(src), dest);
-		else
-			putc(0, dest);
+		void* map = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, EEPROM_SIZE);
+		if(map != NULL)
+		{
+			virtual_eeprom = (uint8_t*)map;
+		}
+		CloseHandle(mapping);
 	}
 	
-	if(src!=NULL)
-		getc(src);
-	putc(value, dest);
+	CloseHandle(file);
+}
+
+static void mcu_eeprom_sync()
+{
+	if(virtual_eeprom != virtual_eeprom_ram)
+	{
+		FlushViewOfFile(virtual_eeprom, EEPROM_SIZE);
+	}
+}
+#endif
+
+void mcu_eeprom_read(uint16_t address, uint8_t* buffer, uint16_t len)
+{
+	for(; len != 0; len--)
+	{
+		*buffer++ = (address < EEPROM_SIZE) ? virtual_eeprom[address] : 0;
+		address++;
+	}
+}
+
+void mcu_eeprom_write(uint16_t address, const uint8_t* buffer, uint16_t len)
+{
+	if(address >= EEPROM_SIZE)
+	{
+		return;
+	}
 	
-	for(int i = address + 1; i < 1024; i++)
+	len = MIN(len, EEPROM_SIZE - address);
+	//only syncs if something changed
+	if(memcmp(&virtual_eeprom[address], buffer, len))
 	{
-		if(src!=NULL)
-			putc(getc(src), dest);
-		else
-			putc(0, dest);
+		memcpy(&virtual_eeprom[address], buffer, len);
+		mcu_eeprom_sync();
+	}
+}
+
+#ifdef ENABLE_PROGRAM_STORAGE
+static FILE* storage_fp = NULL;
+
+uint32_t mcu_storage_open()
+{
+	if(storage_fp!=NULL)
+	{
+		fclose(storage_fp);
 	}
 	
-	if(src!=NULL)
-		fclose(src);
-	fflush(dest);
-	fclose(dest);
-	remove("virtualeeprom");
-	rename("newvirtualeeprom", "virtualeeprom");
+	storage_fp = fopen(STORAGE_FILE, "rb");
+	if(storage_fp==NULL)
+	{
+		return 0;
+	}
 	
-	return value;
+	fseek(storage_fp, 0, SEEK_END);
+	long size = ftell(storage_fp);
+	return (size > 0) ? (uint32_t)size : 0;
 }
 
+uint16_t mcu_storage_read(uint32_t offset, uint8_t* buffer, uint16_t len)
+{
+	if(storage_fp==NULL || fseek(storage_fp, offset, SEEK_SET))
+	{
+		return 0;
+	}
+	
+	return (uint16_t)fread(buffer, 1, len, storage_fp);
+}
+#endif
+
 void mcu_startPerfCounter()
 {
 	startCycleCounter();
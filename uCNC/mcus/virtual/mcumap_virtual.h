@@ -40,6 +40,13 @@
 #define COMPORT ""
 #endif
 
+//eeprom size in bytes
+#define EEPROM_SIZE 1024
+
+//program storage host file and read block size
+#define STORAGE_FILE "program.nc"
+#define STORAGE_BLOCK_SIZE 512
+
 //defines a pointer to an unknow stucture that is defined in the mcu_virtual
 typedef struct virtual_map_t
 {
@@ -57,11 +64,17 @@ extern virtports_t virtualports;
 #define STEP0 0
 #define STEP1 1
 #define STEP2 2
+#ifdef ENABLE_ROTARY_AXIS_A
+#define STEP3 3
+#endif
 #define STEPS_OUTREG virtualports->steps
 
 #define DIR0 0
 #define DIR1 1
 #define DIR2 2
+#ifdef ENABLE_ROTARY_AXIS_A
+#define DIR3 3
+#endif
 #define DIRS_OUTREG virtualports->dirs
 
 //critical inputs
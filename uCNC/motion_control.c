@@ -17,6 +17,7 @@
 
 #include <math.h>
 #include <string.h>
+#include <float.h>
 #include "config.h"
 #include "mcudefs.h"
 #include "mcumap.h"
@@ -30,23 +31,308 @@
 #include "planner.h"
 #include "interpolator.h"
 #include "cnc.h"
+#include "heightmap.h"
 #include "motion_control.h"
 
+//relative distance between the start and end points of an arc below which the arc is a full circle (twice the float resolution)
+#define MC_ARC_POSITION_EPSILON (2 * FLT_EPSILON)
+
+typedef struct
+{
+	float target[AXIS_COUNT];
+	planner_block_data_t block_data;
+} mc_block_t;
+
 static bool mc_checkmode;
+/*
+	queue of validated blocks waiting for space in the planner
+	this allows the parser to continue to process the next commands while the planner is full
+	the queue is after the parser execution and not before it because each line is validated against
+	the modal state, coordinate systems and position left by the previous line (that only the execution updates)
+	queuing parsed lines would also need a full parser state per entry and an arc would still wait for the planner
+*/
+static mc_block_t mc_data[MC_BUFFER_SIZE];
+static uint8_t mc_data_write;
+static uint8_t mc_data_read;
+static uint8_t mc_data_slots;
+//position at the end of the last queued motion
+static float mc_last_pos[AXIS_COUNT];
+#ifdef ENABLE_HEIGHTMAP
+//height map offset of the last queued motion (mc_last_pos is not compensated)
+static float mc_last_offset;
+#endif
+#ifdef AXIS_ROTARY
+//machine position of the 0 degrees of the rotary axis (mc_last_pos is wrapped to a single turn)
+static float mc_rotary_origin;
+#endif
+
+/*
+	Motion control buffer functions
+*/
+static inline void mc_buffer_read()
+{
+	mc_data_read++;
+	mc_data_slots++;
+	if (mc_data_read == MC_BUFFER_SIZE)
+	{
+		mc_data_read = 0;
+	}
+}
+
+static inline void mc_buffer_write()
+{
+	mc_data_write++;
+	mc_data_slots--;
+	if (mc_data_write == MC_BUFFER_SIZE)
+	{
+		mc_data_write = 0;
+	}
+}
+
+bool mc_buffer_is_empty()
+{
+	return (mc_data_slots == MC_BUFFER_SIZE);
+}
+
+static inline bool mc_buffer_is_full()
+{
+	return (mc_data_slots == 0);
+}
+
+uint8_t mc_get_buffer_freeslots()
+{
+	return mc_data_slots;
+}
+
+//queues the block (the caller must check for a free slot first)
+static void mc_buffer_add(float *target, planner_block_data_t *block_data)
+{
+	mc_block_t *block = &mc_data[mc_data_write];
+	if (target != NULL)
+	{
+		memcpy(block->target, target, sizeof(block->target));
+	}
+	memcpy(&block->block_data, block_data, sizeof(planner_block_data_t));
+	mc_buffer_write();
+}
 
 void mc_init()
 {
 	#ifdef FORCE_GLOBALS_TO_0
 	mc_checkmode = false;
+	memset(mc_data, 0, sizeof(mc_data));
+	memset(mc_last_pos, 0, sizeof(mc_last_pos));
+	#ifdef ENABLE_HEIGHTMAP
+	mc_last_offset = 0;
 	#endif
+	#ifdef AXIS_ROTARY
+	mc_rotary_origin = 0;
+	#endif
+	#endif
+	mc_data_write = 0;
+	mc_data_read = 0;
+	mc_data_slots = MC_BUFFER_SIZE;
+}
+
+void mc_clear()
+{
+	mc_data_write = 0;
+	mc_data_read = 0;
+	mc_data_slots = MC_BUFFER_SIZE;
+	mc_resync_position();
+}
+
+//sends the queued blocks to the planner while there is room
+void mc_run()
+{
+	while (!mc_buffer_is_empty() && !planner_buffer_is_full())
+	{
+		mc_block_t *block = &mc_data[mc_data_read];
+		planner_add_line((block->block_data.motion_mode != PLANNER_MOTION_MODE_NOMOTION) ? block->target : NULL, block->block_data);
+		mc_buffer_read();
+	}
+}
+
+void mc_get_position(float *target)
+{
+	memcpy(target, mc_last_pos, sizeof(mc_last_pos));
 }
 
+void mc_resync_position()
+{
+	//resyncs the position with the planner
+	planner_get_position(mc_last_pos);
+#ifdef ENABLE_HEIGHTMAP
+	mc_last_offset = hmap_get_offset(mc_last_pos[AXIS_X], mc_last_pos[AXIS_Y]);
+	mc_last_pos[AXIS_Z] -= mc_last_offset;
+#endif
+#ifdef AXIS_ROTARY
+	float angle = mc_rotary_wrap(mc_last_pos[AXIS_ROTARY]);
+	mc_rotary_origin = mc_last_pos[AXIS_ROTARY] - angle;
+	mc_last_pos[AXIS_ROTARY] = angle;
+#endif
+}
+
+#ifdef AXIS_ROTARY
+float mc_rotary_wrap(float angle)
+{
+	angle = fmodf(angle, 360.0f);
+	if (angle < 0)
+	{
+		angle += 360.0f;
+	}
+
+	//small negative angles round up to a full turn
+	return (angle < 360.0f) ? angle : 0;
+}
+
+//sets the rotary axis of an absolute target to the angle reached by the shortest path from the last position
+void mc_rotary_shortest_path(float *target)
+{
+	float delta = mc_rotary_wrap(target[AXIS_ROTARY] - mc_last_pos[AXIS_ROTARY]);
+	if (delta > 180.0f)
+	{
+		delta -= 360.0f;
+	}
+	target[AXIS_ROTARY] = mc_last_pos[AXIS_ROTARY] + delta;
+}
+#endif
+
 bool mc_toogle_checkmode()
 {
+#ifdef ENABLE_CHECKMODE_SIMULATION
+	//waits for the motions in the buffers to complete before entering check mode
+	//before leaving check mode sends all queued blocks to the simulation
+	while ((!mc_buffer_is_empty() || (!mc_checkmode && (!planner_buffer_is_empty() || cnc_get_exec_state(EXEC_RUN)))) && !cnc_get_exec_state(EXEC_ABORT))
+	{
+		cnc_doevents();
+	}
+#endif
 	mc_checkmode = !mc_checkmode;
+#ifdef ENABLE_CHECKMODE_SIMULATION
+	itp_sim_enable(mc_checkmode);
+#endif
+	return mc_checkmode;
+}
+
+bool mc_get_checkmode()
+{
 	return mc_checkmode;
 }
 
+//queues a line motion
+static void mc_line_segment(float *target, planner_block_data_t block_data)
+{
+	while (mc_buffer_is_full())
+	{
+		cnc_doevents();
+	}
+
+#ifdef ENABLE_HEIGHTMAP
+	//the planner receives the compensated target
+	float offset = hmap_get_offset(target[AXIS_X], target[AXIS_Y]);
+#endif
+
+	if(block_data.motion_mode != PLANNER_MOTION_MODE_NOMOTION)
+	{
+		for (uint8_t i = AXIS_COUNT; i != 0;)
+		{
+			i--;
+			block_data.dir_vect[i] = target[i] - mc_last_pos[i];
+#ifdef ENABLE_HEIGHTMAP
+			if (i == AXIS_Z)
+			{
+				block_data.dir_vect[i] += offset - mc_last_offset;
+			}
+#endif
+			if (block_data.dir_vect[i] != 0)
+			{
+				block_data.distance += (block_data.dir_vect[i] * block_data.dir_vect[i]);
+			}
+		}
+		
+		block_data.distance = sqrtf(block_data.distance);
+		if(block_data.motion_mode == PLANNER_MOTION_MODE_INVERSEFEED)
+		{
+			//calculates feed rate in reverse feed rate mode
+			block_data.feed = block_data.distance / block_data.feed;
+		}
+	}
+
+#if(defined(ENABLE_HEIGHTMAP) || defined(AXIS_ROTARY))
+	float machine_target[AXIS_COUNT];
+	memcpy(machine_target, target, sizeof(machine_target));
+#ifdef ENABLE_HEIGHTMAP
+	machine_target[AXIS_Z] += offset;
+	mc_last_offset = offset;
+#endif
+#ifdef AXIS_ROTARY
+	machine_target[AXIS_ROTARY] += mc_rotary_origin;
+#endif
+	mc_buffer_add(machine_target, &block_data);
+#else
+	mc_buffer_add(target, &block_data);
+#endif
+	memcpy(mc_last_pos, target, sizeof(mc_last_pos));
+}
+
+//queues a line motion (split in segments for non linear kinematics)
+static void mc_line_kinematics(float *target, planner_block_data_t block_data)
+{
+#ifdef KINEMATICS_NONLINEAR
+	if (block_data.motion_mode != PLANNER_MOTION_MODE_NOMOTION)
+	{
+		/*
+			the interpolator moves the steppers in a straight line between the ends of each planner block
+			with non linear kinematics that is a curve in the machine space so the line is split in segments
+			the number of segments is given by the duration of the motion at the programmed feed (limited by the max feed of the axis)
+		*/
+		float dir_vect[AXIS_COUNT];
+		float distance = 0;
+		float duration = 0;
+		for (uint8_t i = AXIS_COUNT; i != 0;)
+		{
+			i--;
+			dir_vect[i] = target[i] - mc_last_pos[i];
+			distance += dir_vect[i] * dir_vect[i];
+			float axis_duration = fabsf(dir_vect[i]) * g_settings_derived.max_feed_rate_inv[i];
+			duration = MAX(duration, axis_duration);
+		}
+
+		distance = sqrtf(distance);
+		float feed_duration = distance / block_data.feed;
+		duration = MAX(duration, feed_duration);
+		float segments = duration * KINEMATICS_SEGMENTS_PER_SECOND;
+		float max_segments = distance * (1.0f / KINEMATICS_MIN_SEGMENT_LENGTH);
+		segments = MIN(segments, max_segments);
+		uint16_t segment_count = (segments < (float)(UINT16_MAX - 1)) ? ((uint16_t)segments + 1) : (UINT16_MAX - 1);
+		float segment_inv = 1.0f / (float)segment_count;
+		float segment_pos[AXIS_COUNT];
+
+		for (uint8_t i = AXIS_COUNT; i != 0;)
+		{
+			i--;
+			dir_vect[i] *= segment_inv;
+			segment_pos[i] = mc_last_pos[i];
+		}
+
+		for (uint16_t s = 1; s < segment_count; s++)
+		{
+			for (uint8_t i = AXIS_COUNT; i != 0;)
+			{
+				i--;
+				segment_pos[i] += dir_vect[i];
+			}
+
+			mc_line_segment(segment_pos, block_data);
+		}
+	}
+#endif
+
+	//last segment arrives at the target location
+	mc_line_segment(target, block_data);
+}
+
 uint8_t mc_line(float *target, planner_block_data_t block_data)
 {
 	/*if(io_get_limits(LIMITS_MASK))
@@ -66,53 +352,127 @@ uint8_t mc_line(float *target, planner_block_data_t block_data)
 		return STATUS_OK;
 	}
 
+#ifndef ENABLE_CHECKMODE_SIMULATION
 	if (mc_checkmode) // check mode (gcode simulation) doesn't send code to planner
 	{
 		return STATUS_OK;
 	}
+#endif
 
-	while (planner_buffer_is_full())
+#ifdef AXIS_ROTARY
+	//the rotary axis moves by the commanded travel (absolute targets are set to the shortest path by mc_rotary_shortest_path)
+	float rotary_delta = target[AXIS_ROTARY] - mc_last_pos[AXIS_ROTARY];
+	if (block_data.motion_mode == PLANNER_MOTION_MODE_FEED && rotary_delta != 0 && block_data.feed != FLT_MAX)
 	{
-		cnc_doevents();
-	}
-
-	if(block_data.motion_mode != PLANNER_MOTION_MODE_NOMOTION)
-	{
-		float mc_position[AXIS_COUNT];
-
-		//copy planner last position
-		planner_get_position(mc_position);
+		//the feed applies to the linear axis and the planner feed is scaled to the combined distance
+		//motions of the rotary axis alone use the feed in degrees
+		float linear_distance = 0;
 		for (uint8_t i = AXIS_COUNT; i != 0;)
 		{
 			i--;
-			block_data.dir_vect[i] = target[i] - mc_position[i];
-			if (block_data.dir_vect[i] != 0)
+			if (i != AXIS_ROTARY)
 			{
-				block_data.distance += (block_data.dir_vect[i] * block_data.dir_vect[i]);
+				float delta = target[i] - mc_last_pos[i];
+				linear_distance += delta * delta;
 			}
 		}
-		
-		block_data.distance = sqrtf(block_data.distance);
-		if(block_data.motion_mode == PLANNER_MOTION_MODE_INVERSEFEED)
+
+		if (linear_distance != 0)
 		{
-			//calculates feed rate in reverse feed rate mode
-			block_data.feed = block_data.distance / block_data.feed;
+			block_data.feed *= sqrtf((linear_distance + rotary_delta * rotary_delta) / linear_distance);
 		}
 	}
+#endif
+
+#if(defined(KINEMATICS_NONLINEAR) || defined(ENABLE_HEIGHTMAP))
+	if (block_data.motion_mode == PLANNER_MOTION_MODE_INVERSEFEED)
+	{
+		//the segments of a split line run at the feed of the whole line
+		float distance = 0;
+		for (uint8_t i = AXIS_COUNT; i != 0;)
+		{
+			i--;
+			float delta = target[i] - mc_last_pos[i];
+			distance += delta * delta;
+		}
+
+		block_data.feed = sqrtf(distance) / block_data.feed;
+		block_data.motion_mode = PLANNER_MOTION_MODE_FEED;
+	}
+#endif
+
+#ifdef ENABLE_HEIGHTMAP
+	if (hmap_is_active() && block_data.motion_mode != PLANNER_MOTION_MODE_NOMOTION)
+	{
+		//splits the line at the height map cell borders
+		float start[AXIS_COUNT];
+		float segment_pos[AXIS_COUNT];
+		float t = 0;
+		memcpy(start, mc_last_pos, sizeof(start));
+		for (;;)
+		{
+			t = hmap_next_border(start, target, t);
+			if (t >= 1)
+			{
+				break;
+			}
+
+			for (uint8_t i = AXIS_COUNT; i != 0;)
+			{
+				i--;
+				segment_pos[i] = start[i] + t * (target[i] - start[i]);
+			}
 
-	planner_add_line(target, block_data);
+			mc_line_kinematics(segment_pos, block_data);
+		}
+	}
+#endif
+
+	mc_line_kinematics(target, block_data);
+#ifdef AXIS_ROTARY
+	//keeps the position of the rotary axis in a single turn
+	//only done at the end of the line because the segments are computed from the unwrapped start and target
+	float angle = mc_rotary_wrap(mc_last_pos[AXIS_ROTARY]);
+	mc_rotary_origin += mc_last_pos[AXIS_ROTARY] - angle;
+	mc_last_pos[AXIS_ROTARY] = angle;
+#endif
 	return STATUS_OK;
 }
 
-//applies an algorithm similar to grbl with slight changes
+//fast atan2 aproximation (polynomial aproximation of atan in the [-1, 1] range with a max error of ~1e-5 rad)
+static float mc_atan2(float y, float x)
+{
+	if (x == 0 && y == 0)
+	{
+		return 0;
+	}
+
+	bool swap = (fabsf(y) > fabsf(x));
+	float z = (swap) ? (x / y) : (y / x);
+	float z_sqr = z * z;
+	float angle = z * (0.9998660f + z_sqr * (-0.3302995f + z_sqr * (0.1801410f + z_sqr * (-0.0851330f + z_sqr * 0.0208351f))));
+
+	if (swap) //atan(y/x) = +-pi/2 - atan(x/y)
+	{
+		angle = (((y < 0) != (x < 0)) ? -M_PI_2 : M_PI_2) - angle;
+	}
+
+	if (x < 0)
+	{
+		angle += (y >= 0) ? M_PI : -M_PI;
+	}
+
+	return angle;
+}
+
 uint8_t mc_arc(float *target, float center_offset_a, float center_offset_b, float radius, uint8_t plane, bool isclockwise, planner_block_data_t block_data)
 {
 	uint8_t axis_0 = 0;
 	uint8_t axis_1 = 0;
 	float mc_position[AXIS_COUNT];
 
-	//copy planner last position
-	planner_get_position(mc_position);
+	//copy last queued position
+	mc_get_position(mc_position);
 
 	//start points
 	switch (plane)
@@ -136,16 +496,33 @@ uint8_t mc_arc(float *target, float center_offset_a, float center_offset_b, floa
 
 	float pt0_a = -center_offset_a; // Radius vector from center to current location
 	float pt0_b = -center_offset_b;
-	float pt1_a = target[axis_0] - ptcenter_a; // Radius vector from center to current location
+	float pt1_a = target[axis_0] - ptcenter_a; // Radius vector from center to target location
 	float pt1_b = target[axis_1] - ptcenter_b;
+	float radius_sqr = pt0_a * pt0_a + pt0_b * pt0_b;
+
+	//no arc to be made
+	if (radius_sqr == 0 || radius <= 0)
+	{
+		return mc_line(target, block_data);
+	}
 
 	//dot product between vect_a and vect_b
 	float dotprod = pt0_a * pt1_a + pt0_b * pt1_b;
 	//determinant
 	float det = pt0_a * pt1_b - pt0_b * pt1_a;
-	float arc_angle = atan2(det, dotprod);
-
-	if (isclockwise)
+	float arc_angle = mc_atan2(det, dotprod);
+
+	/*
+		if the start and end points are the same the arc is a full circle
+		pt1 is not bit exact with -offset so det is a tiny value of either sign
+		the points are the same if the distance between them is within the float resolution of the coordinates
+	*/
+	float coord_span = fabsf(ptcenter_a) + fabsf(ptcenter_b) + fabsf(center_offset_a) + fabsf(center_offset_b);
+	if ((fabsf(target[axis_0] - mc_position[axis_0]) + fabsf(target[axis_1] - mc_position[axis_1])) <= (coord_span * MC_ARC_POSITION_EPSILON))
+	{
+		arc_angle = (isclockwise) ? (-2 * M_PI) : (2 * M_PI);
+	}
+	else if (isclockwise)
 	{
 		if (arc_angle >= 0)
 		{
@@ -160,57 +537,65 @@ uint8_t mc_arc(float *target, float center_offset_a, float center_offset_b, floa
 		}
 	}
 
-	uint16_t segment_count = floor(fabs(0.5 * arc_angle * radius) / sqrt(g_settings.arc_tolerance * (2 * radius - g_settings.arc_tolerance)));
-	float arc_per_sgm = (segment_count != 0) ? arc_angle/segment_count : arc_angle;
-	float dist_sgm = 0;
-	
+	/*
+		the chord error (sagitta) of a segment that spans an angle theta is
+		r * (1 - cos(theta/2)) ~= r * theta^2 / 8 <= arc_tolerance
+		so the maximum angle per segment is sqrt(8 * arc_tolerance / r)
+		and the number of segments is angle / sqrt(8 * arc_tolerance / r)
+		the segment count is rounded up so it's always at least 1 segment
+	*/
+	float segments = fabsf(arc_angle) * sqrtf(radius / (8 * g_settings.arc_tolerance));
+	//limits the angle per segment to 0.5 rad to keep the sine and cosine aproximation error low
+	if (segments < 2 * fabsf(arc_angle))
+	{
+		segments = 2 * fabsf(arc_angle);
+	}
+	uint16_t segment_count = (segments < (float)(UINT16_MAX - 1)) ? ((uint16_t)segments + 1) : (UINT16_MAX - 1);
+	float segment_inv = 1.0f / (float)segment_count;
+	float arc_per_sgm = arc_angle * segment_inv;
+
 	//for all other axis finds the linear motion distance
 	float increment[AXIS_COUNT];
-	
+
 	for (uint8_t i = AXIS_COUNT; i != 0;)
 	{
 		i--;
-		increment[i] = (target[i] - mc_position[i])/segment_count;
+		increment[i] = (target[i] - mc_position[i]) * segment_inv;
 	}
-	
+
 	increment[axis_0] = 0;
 	increment[axis_1] = 0;
-	
-	if(block_data.motion_mode == PLANNER_MOTION_MODE_INVERSEFEED)
+
+	if (block_data.motion_mode == PLANNER_MOTION_MODE_INVERSEFEED)
 	{
 		//split the required time to complete the motion with the number of segments
-		block_data.feed /= segment_count;
+		block_data.feed *= segment_inv;
 	}
 
-	//calculates an aproximation to sine and cosine of the angle segment
-	//improves the error for the cosine by calculating an extra term of the taylor series at the expence of an extra multiplication and addition
-	//applies arc correction has grbl does
+	//calculates the sine and cosine of the angle segment (computed once per arc)
+	//uses the taylor series up to the 5th order for sine and 4th order for cosine
 	float arc_per_sgm_sqr = arc_per_sgm * arc_per_sgm;
-	float cos_per_sgm = 1 - 0.1666666667f * arc_per_sgm_sqr;
-	float sin_per_sgm = arc_per_sgm * cos_per_sgm;
-	cos_per_sgm = 1 - 0.25f * arc_per_sgm_sqr * (cos_per_sgm + 1);
-
+	float sin_per_sgm = arc_per_sgm * (1 - 0.1666666667f * arc_per_sgm_sqr * (1 - 0.05f * arc_per_sgm_sqr));
+	float cos_per_sgm = 1 - 0.5f * arc_per_sgm_sqr * (1 - 0.0833333333f * arc_per_sgm_sqr);
+	//inverse of the radius squared used to correct the radius vector drift
+	float radius_sqr_inv = 1.0f / radius_sqr;
 	uint8_t count = 0;
 
 	for (uint16_t i = 1; i < segment_count; i++)
 	{
-		if (count < N_ARC_CORRECTION)
-		{
-			// Apply incremental vector rotation matrix.
-			float new_pt = pt0_a * sin_per_sgm + pt0_b * cos_per_sgm;
-			pt0_a = pt0_a * cos_per_sgm - pt0_b * sin_per_sgm;
-			pt0_b = new_pt;
-			count++;
-		}
-		else
+		// Apply incremental vector rotation matrix.
+		float new_pt = pt0_a * sin_per_sgm + pt0_b * cos_per_sgm;
+		pt0_a = pt0_a * cos_per_sgm - pt0_b * sin_per_sgm;
+		pt0_b = new_pt;
+
+		if (++count == N_ARC_CORRECTION)
 		{
-			// Arc correction to radius vector. Computed only every N_ARC_CORRECTION increments.
-			// Compute exact location by applying transformation matrix from initial radius vector(=-offset).
-			float angle = i * arc_per_sgm;
-			float precise_cos = cos(angle);
-			float precise_sin = (angle <= M_PI) ? -sqrt(1 - precise_cos * precise_cos) : sqrt(1 - precise_cos * precise_cos); //faster than sin function
-			pt0_a = -center_offset_a * precise_cos + center_offset_b * precise_sin;
-			pt0_b = -center_offset_a * precise_sin - center_offset_b * precise_cos;
+			// Corrects the radius vector length drift every N_ARC_CORRECTION increments.
+			// Applies a single Newton iteration of 1/sqrt(x) around 1 (no sqrt or trig needed)
+			// scale = 1.5 - 0.5 * |pt|^2 / r^2
+			float scale = 1.5f - 0.5f * (pt0_a * pt0_a + pt0_b * pt0_b) * radius_sqr_inv;
+			pt0_a *= scale;
+			pt0_b *= scale;
 			count = 0;
 		}
 
@@ -238,19 +623,21 @@ uint8_t mc_arc(float *target, float center_offset_a, float center_offset_b, floa
 
 uint8_t mc_dwell(planner_block_data_t block_data)
 {
+#ifndef ENABLE_CHECKMODE_SIMULATION
 	if (mc_checkmode) // check mode (gcode simulation) doesn't send code to planner
 	{
 		return STATUS_OK;
 	}
+#endif
 
-	while (planner_buffer_is_full())
+	while (mc_buffer_is_full())
 	{
 		cnc_doevents();
 	}
 
 	//send dwell (planner linear motion with distance == 0)
 	block_data.motion_mode = PLANNER_MOTION_MODE_NOMOTION;
-	planner_add_line(NULL, block_data);
+	mc_buffer_add(NULL, &block_data);
 	return STATUS_OK;
 }
 
@@ -258,7 +645,7 @@ uint8_t mc_home_axis(uint8_t axis, uint8_t axis_limit)
 {
 	float target[AXIS_COUNT];
 	uint8_t axis_mask = (1 << axis);
-	planner_block_data_t block_data;
+	planner_block_data_t block_data = {};
 
 	planner_get_position(target);
 	
@@ -306,13 +693,12 @@ uint8_t mc_home_axis(uint8_t axis, uint8_t axis_limit)
 		return EXEC_ALARM_HOMING_FAIL_RESET;
 	}
 
-	//if limit was not triggered
-	if (!io_get_limits(axis_limit))
+	//if any of the axis limits was not triggered
+	if (io_get_limits(axis_limit) != axis_limit)
 	{
 		return EXEC_ALARM_HOMING_FAIL_APPROACH;
 	}
 
-
 	//zero's the planner
 	planner_get_position(target);
 	max_home_dist = g_settings.homing_offset * 5.0f;
@@ -359,18 +745,20 @@ uint8_t mc_home_axis(uint8_t axis, uint8_t axis_limit)
 
 uint8_t mc_spindle_coolant(planner_block_data_t block_data)
 {
+#ifndef ENABLE_CHECKMODE_SIMULATION
 	if (mc_checkmode) // check mode (gcode simulation) doesn't send code to planner
 	{
 		return STATUS_OK;
 	}
+#endif
 
-	while (planner_buffer_is_full())
+	while (mc_buffer_is_full())
 	{
 		cnc_doevents();
 	}
 
 	block_data.motion_mode = PLANNER_MOTION_MODE_NOMOTION;
-	planner_add_line(NULL, block_data);
+	mc_buffer_add(NULL, &block_data);
 	return STATUS_OK;
 }
 
@@ -379,12 +767,19 @@ uint8_t mc_probe(float *target, bool invert_probe, planner_block_data_t block_da
 	mcu_enable_probe_isr();
 	
 	mc_line(target, block_data);
+	//waits for the probe motion to be sent to the planner and executed
 	do
 	{
 		cnc_doevents();
-	} while (cnc_get_exec_state(EXEC_RUN));
+	} while ((!mc_buffer_is_empty() || cnc_get_exec_state(EXEC_RUN)) && !cnc_get_exec_state(EXEC_ABORT));
 
 	mcu_disable_probe_isr();
+#ifdef ENABLE_CHECKMODE_SIMULATION
+	if (mc_checkmode) //simulated probe motions are always successful
+	{
+		return STATUS_OK;
+	}
+#endif
 	bool probe_notok = (!invert_probe) ? !io_get_probe() : io_get_probe();
 	if(probe_notok)
 	{
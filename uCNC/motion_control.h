@@ -24,12 +24,24 @@
 #include "planner.h"
 
 void mc_init();
+void mc_clear();
+void mc_run();
+bool mc_buffer_is_empty();
+uint8_t mc_get_buffer_freeslots();
+void mc_get_position(float *target);
+void mc_resync_position();
 bool mc_toogle_checkmode();
+bool mc_get_checkmode();
 uint8_t mc_line(float *target, planner_block_data_t block_data);
 uint8_t mc_arc(float *target, float center_offset_a, float center_offset_b, float radius, uint8_t plane, bool isclockwise, planner_block_data_t block_data);
 uint8_t mc_dwell(planner_block_data_t block_data);
 uint8_t mc_home_axis(uint8_t axis, uint8_t axis_limit);
 uint8_t mc_spindle_coolant(planner_block_data_t block_data);
 uint8_t mc_probe(float *target, bool invert_probe, planner_block_data_t block_data);
+#ifdef AXIS_ROTARY
+//returns the angle between 0 and 360 degrees
+float mc_rotary_wrap(float angle);
+void mc_rotary_shortest_path(float *target);
+#endif
 
 #endif
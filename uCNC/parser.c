@@ -35,6 +35,10 @@
 #include "interpolator.h"
 #include "cnc.h"
 #include "parser.h"
+#include "binary_gcode.h"
+#include "spline.h"
+#include "storage.h"
+#include "heightmap.h"
 
 #include <stdio.h>
 #include <math.h>
@@ -154,6 +158,8 @@ static parser_state_t parser_state;
 static parser_parameters_t parser_parameters;
 static float parser_last_probe[AXIS_COUNT];
 static uint8_t parser_last_probe_ok;
+//offset of the last G5 second control point (used by the next G5 if I and J are omitted)
+static float parser_last_spline_pq[2];
 //static float parser_offset_pos[AXIS_COUNT];
 //static float parser_max_feed_rate;
 //contains all bitflags for the used groups/words on the parsed command
@@ -164,9 +170,14 @@ static uint8_t parser_word1;
 static uint8_t parser_word2;
 
 static uint8_t parser_wco_counter;
+//last value of the delta coded words of the binary gcode frames (fixed point with BINARY_GCODE_DELTA_DECIMALS)
+static int32_t parser_frame_words[BINARY_GCODE_DELTA_WORDS];
 
 static void parser_reset();
 static bool parser_get_float(float *value, bool *isinteger);
+static uint8_t parser_get_frame(uint8_t *frame, uint8_t *len);
+static bool parser_get_frame_number(uint8_t *frame, uint8_t *pos, uint8_t len, uint8_t *scale, int32_t *value);
+static bool parser_get_frame_word(uint8_t op, uint8_t *frame, uint8_t *pos, uint8_t len, uint8_t *step, char *word, float *value, bool *isinteger);
 static uint8_t parser_fetch_command(parser_state_t *new_state);
 static uint8_t parser_validate_command(parser_state_t *new_state);
 static uint8_t parser_exec_command(parser_state_t *new_state);
@@ -181,10 +192,18 @@ void parser_init()
 	memset(&parser_last_probe, 0, sizeof(parser_last_probe));
 	parser_last_probe_ok = 0;
 	#endif
-	settings_load(SETTINGS_PARSER_PARAMETERS_ADDRESS_OFFSET, (uint8_t *)&parser_parameters, sizeof(parser_parameters_t));
+	settings_load_parameters((uint8_t *)&parser_parameters, sizeof(parser_parameters_t));
 	parser_reset();
 }
 
+/*
+	Clears the last values of the delta coded words of the binary gcode frames
+*/
+void parser_clear()
+{
+	memset(parser_frame_words, 0, sizeof(parser_frame_words));
+}
+
 /*
 	Parse the next gcode line available in the buffer and send it to the motion controller
 */
@@ -249,6 +268,97 @@ static uint8_t parser_eat_next_char(unsigned char c)
 	return STATUS_OK;
 }
 
+#ifdef ENABLE_HEIGHTMAP
+//$L (prints the height map), $LC (disables the compensation) or $L=X<length>Y<length>Z<depth>F<feed> (probes a new height map)
+static uint8_t parser_heightmap_command()
+{
+	unsigned char c = serial_getc();
+	switch (c)
+	{
+	case '\n':
+		protocol_send_heightmap();
+		return STATUS_OK;
+	case 'C':
+	case '=':
+		//the probes don't move in check mode and the stored height map would be replaced by a flat map
+		if (mc_get_checkmode())
+		{
+			return STATUS_IDLE_ERROR;
+		}
+		break;
+	default:
+		return STATUS_INVALID_STATEMENT;
+	}
+
+	if (c == 'C')
+	{
+		if (parser_eat_next_char('\n'))
+		{
+			return STATUS_INVALID_STATEMENT;
+		}
+		hmap_clear();
+		return STATUS_OK;
+	}
+
+	if (cnc_get_exec_state(EXEC_LOCKED))
+	{
+		return STATUS_SYSTEM_GC_LOCK;
+	}
+
+	//X, Y, Z and F words
+	float words[4] = {0, 0, 0, 0};
+	for (;;)
+	{
+		c = serial_getc();
+		if (c == '\n')
+		{
+			break;
+		}
+
+		uint8_t word;
+		switch (c)
+		{
+		case 'X':
+			word = 0;
+			break;
+		case 'Y':
+			word = 1;
+			break;
+		case 'Z':
+			word = 2;
+			break;
+		case 'F':
+			word = 3;
+			break;
+		default:
+			return STATUS_EXPECTED_COMMAND_LETTER;
+		}
+
+		bool isinteger;
+		if (!parser_get_float(&words[word], &isinteger))
+		{
+			return STATUS_BAD_NUMBER_FORMAT;
+		}
+	}
+
+	for (uint8_t i = 0; i < 4; i++)
+	{
+		if (words[i] <= 0)
+		{
+			return STATUS_GCODE_VALUE_WORD_MISSING;
+		}
+	}
+
+	uint8_t error = hmap_probe(words[0], words[1], words[2], words[3] * MIN_SEC_MULT);
+	if (error)
+	{
+		cnc_alarm(error);
+	}
+
+	return STATUS_OK;
+}
+#endif
+
 uint8_t parser_grbl_command()
 {
 	//if not IDLE
@@ -289,6 +399,17 @@ uint8_t parser_grbl_command()
 			error |= parser_eat_next_char('=');
 			protocol_send_string(MSG_FEEDBACK_9);
 			break;
+		case 'P':
+			serial_getc();
+			error = parser_eat_next_char('=');
+			break;
+		case 'F':
+			serial_getc();
+			error = parser_eat_next_char('\n');
+			break;
+		case 'L':
+			serial_getc();
+			break;
 	}
 	
 	if (error)
@@ -349,6 +470,45 @@ uint8_t parser_grbl_command()
 		}
 
 		return parser_eat_next_char('\n');
+	case 'P':
+		//switches between line mode and framed streaming mode
+		c = serial_getc();
+		if((c != '0' && c != '1') || parser_eat_next_char('\n'))
+		{
+			return STATUS_INVALID_STATEMENT;
+		}
+
+		serial_set_framed_mode(c == '1');
+		parser_clear();
+		return STATUS_OK;
+	case 'F':
+		//runs the stored program
+#ifdef ENABLE_PROGRAM_STORAGE
+		if(cnc_get_exec_state(EXEC_LOCKED))
+		{
+			return STATUS_SYSTEM_GC_LOCK;
+		}
+		//a stored program can't start another
+		if(storage_is_running())
+		{
+			return STATUS_IDLE_ERROR;
+		}
+		if(!storage_open())
+		{
+			return STATUS_SETTING_READ_FAIL;
+		}
+		parser_clear();
+		return STATUS_OK;
+#else
+		return STATUS_SETTING_DISABLED;
+#endif
+	case 'L':
+		//height map
+#ifdef ENABLE_HEIGHTMAP
+		return parser_heightmap_command();
+#else
+		return STATUS_SETTING_DISABLED;
+#endif
 	case 'J': //jog command
 		/*
 				The jog command is parsed like an emulated G1 command without changing the parser state
@@ -367,6 +527,9 @@ uint8_t parser_grbl_command()
 		}
 		else
 		{
+#ifdef ENABLE_CHECKMODE_SIMULATION
+			protocol_send_sim_stats();
+#endif
 			cnc_stop();
 			cnc_alarm(EXEC_ALARM_RESET);
 			protocol_send_string(MSG_FEEDBACK_5);
@@ -457,18 +620,22 @@ void parser_parameters_reset()
 {
 	//erase all parameters
 	memset(&parser_parameters, 0, sizeof(parser_parameters_t));
-	settings_save(SETTINGS_PARSER_PARAMETERS_ADDRESS_OFFSET, (const uint8_t *)&parser_parameters, sizeof(parser_parameters_t));
+	settings_save_parameters((const uint8_t *)&parser_parameters, sizeof(parser_parameters_t));
 }
 
-bool parser_get_wco(float *axis)
+void parser_get_wco(float *axis)
+{
+	for (uint8_t i = AXIS_COUNT; i != 0;)
+	{
+		i--;
+		axis[i] = parser_parameters.g92offset[i] + parser_parameters.coord_sys[parser_state.groups.coord_system][i];
+	}
+}
+
+bool parser_get_wco_report()
 {
 	if(!parser_wco_counter)
 	{
-		for (uint8_t i = AXIS_COUNT; i != 0;)
-		{
-			i--;
-			axis[i] = parser_parameters.g92offset[i] + parser_parameters.coord_sys[parser_state.groups.coord_system][i];
-		}
 		parser_wco_counter = STATUS_WCO_REPORT_MIN_FREQUENCY;
 		return true;
 	}
@@ -480,6 +647,9 @@ bool parser_get_wco(float *axis)
 void parser_sync_probe()
 {
 	itp_get_rt_position(parser_last_probe);
+#ifdef AXIS_ROTARY
+	parser_last_probe[AXIS_ROTARY] = mc_rotary_wrap(parser_last_probe[AXIS_ROTARY]);
+#endif
 }
 
 #ifdef USE_COOLANT
@@ -603,6 +773,140 @@ bool parser_get_float(float *value, bool *isinteger)
 	return result;
 }
 
+/*
+	Reads a binary gcode frame from the buffer and checks it's integrity
+	The payload is copied to the frame buffer
+*/
+uint8_t parser_get_frame(uint8_t *frame, uint8_t *len)
+{
+	uint8_t crc = 0;
+	*len = serial_get_frame(frame, BINARY_GCODE_MAX_PAYLOAD + 1);
+
+	if (*len > BINARY_GCODE_MAX_PAYLOAD)
+	{
+		return STATUS_LINE_LENGTH_EXCEEDED;
+	}
+
+	crc = crc7(*len, crc);
+	for (uint8_t i = 0; i < *len; i++)
+	{
+		crc = crc7(frame[i], crc);
+	}
+
+	//the CRC follows the payload
+	if (crc != frame[*len])
+	{
+		return STATUS_BAD_CHECKSUM;
+	}
+
+	return STATUS_OK;
+}
+
+/*
+	Decodes a variable length number of a binary gcode frame
+	If scale is not NULL the number scale is read from the bits 1..0 of the number
+	The frame position is also advanced to the next byte
+*/
+bool parser_get_frame_number(uint8_t *frame, uint8_t *pos, uint8_t len, uint8_t *scale, int32_t *value)
+{
+	uint32_t result = 0;
+
+	for (uint8_t shift = 0; shift < 32; shift += BINARY_GCODE_NUMBER_SHIFT)
+	{
+		if (*pos >= len)
+		{
+			return false;
+		}
+
+		uint8_t c = frame[(*pos)++];
+		result |= (uint32_t)(c & BINARY_GCODE_NUMBER_BITS) << shift;
+		if (!(c & BINARY_GCODE_NUMBER_MORE))
+		{
+			if (scale != NULL)
+			{
+				*scale = result & 0x03;
+				result >>= 2;
+			}
+
+			//zigzag to signed
+			*value = (int32_t)(result >> 1) ^ -(int32_t)(result & 1);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/*
+	Decodes the next word of a binary gcode frame
+	The line number, the motion word implied by the opcode and the axis words are decoded first (step tracks them)
+	The delta coded words are added to the last value of the word and the values are converted from fixed point to float
+	The frame position is also advanced to the next word
+	Returns the word '\0' at the end of the frame
+*/
+bool parser_get_frame_word(uint8_t op, uint8_t *frame, uint8_t *pos, uint8_t len, uint8_t *step, char *word, float *value, bool *isinteger)
+{
+	static const char delta_words[BINARY_GCODE_DELTA_WORDS] = {'X', 'Y', 'Z', 'A', 'B', 'C', 'N'};
+	static const int32_t delta_scale[4] = {10000, 1000, 10, 1};
+	static const float word_scale[4] = {1.0f, 10.0f, 1000.0f, 10000.0f};
+	uint8_t scale;
+	int32_t intval;
+
+	//N (step 0), the implied motion word (step 1) and X to C (steps 2 to 7)
+	while (*step < (BINARY_GCODE_DELTA_WORDS + 1))
+	{
+		uint8_t i = (*step)++;
+
+		if (i == 1)
+		{
+			if (BINARY_GCODE_IS_MOTION(op))
+			{
+				*word = 'G';
+				*value = (float)BINARY_GCODE_MOTION_MODE(op);
+				*isinteger = true;
+				return true;
+			}
+			continue;
+		}
+
+		i = (!i) ? BINARY_GCODE_DELTA_N : (i - 2);
+		if (frame[0] & (1 << i))
+		{
+			//the line number is always an integer and is sent without the scale
+			scale = BINARY_GCODE_SCALE_1;
+			if (!parser_get_frame_number(frame, pos, len, (i != BINARY_GCODE_DELTA_N) ? &scale : NULL, &intval))
+			{
+				return false;
+			}
+
+			parser_frame_words[i] += intval * delta_scale[scale];
+			*word = delta_words[i];
+			*value = (float)parser_frame_words[i] / 10000.0f;
+			*isinteger = !(parser_frame_words[i] % 10000);
+			return true;
+		}
+	}
+
+	if (*pos == len) //end of frame
+	{
+		*word = '\0';
+		return true;
+	}
+
+	uint8_t header = frame[(*pos)++];
+	scale = BINARY_GCODE_WORD_SCALE(header);
+	if (!parser_get_frame_number(frame, pos, len, NULL, &intval))
+	{
+		return false;
+	}
+
+	*word = BINARY_GCODE_WORD_LETTER(header);
+	//division gives the nearest float to the decimal value
+	*value = (float)intval / word_scale[scale];
+	*isinteger = (scale == BINARY_GCODE_SCALE_1);
+	return true;
+}
+
 /*
 	STEP 1
 	Fetches the next line from the mcu communication buffer and preprocesses the string
@@ -612,6 +916,7 @@ bool parser_get_float(float *value, bool *isinteger)
 		3. All letters are upper-cased
 		4. Checks number formats in all words
 		5. Checks for modal groups and words collisions
+	Binary gcode frames are decoded here to the same words and follow the same path
 */
 uint8_t parser_fetch_command(parser_state_t *new_state)
 {
@@ -621,6 +926,13 @@ uint8_t parser_fetch_command(parser_state_t *new_state)
 	uint8_t code = 0;
 	uint8_t wordcount = 0;
 	uint8_t mwords = 0;
+	bool binary = false;
+	uint8_t frame[BINARY_GCODE_MAX_PAYLOAD + 1];
+	uint8_t frame_op = serial_peek();
+	uint8_t frame_len = 0;
+	//the payload starts with the word mask
+	uint8_t frame_pos = 1;
+	uint8_t frame_step = 0;
 
 	//flags for used words and groups
 	parser_group0 = 0;
@@ -629,33 +941,69 @@ uint8_t parser_fetch_command(parser_state_t *new_state)
 	parser_word1 = 0;
 	parser_word2 = 0;
 
+	if (BINARY_GCODE_IS_FRAME(frame_op))
+	{
+		binary = true;
+		uint8_t error = parser_get_frame(frame, &frame_len);
+		if (error)
+		{
+			return error;
+		}
+
+		if (!frame_len)
+		{
+			return STATUS_BAD_NUMBER_FORMAT;
+		}
+	}
+
 	for (;;)
 	{
-		word = serial_getc();
 		bool isinteger = false;
 
-		switch (word)
+		if (binary)
 		{
-		case '\n':
-		case '\0':
-			//word = '\n'; //EOL marker
-			return STATUS_OK;
-		default:
-			if (word >= 'a' && word <= 'z') //uppercase
+			if (!parser_get_frame_word(frame_op, frame, &frame_pos, frame_len, &frame_step, &word, &word_val, &isinteger))
 			{
-				word -= 32;
+				return STATUS_BAD_NUMBER_FORMAT;
+			}
+
+			if (word == '\0') //end of frame
+			{
+				return STATUS_OK;
 			}
 
-			if (word < 'A' || word > 'Z') //invalid recognized char
+			if (word > 'Z') //invalid letter index
 			{
 				return STATUS_EXPECTED_COMMAND_LETTER;
 			}
-			break;
 		}
-
-		if (!parser_get_float(&word_val, &isinteger))
+		else
 		{
-			return STATUS_BAD_NUMBER_FORMAT;
+			word = serial_getc();
+
+			switch (word)
+			{
+			case '\n':
+			case '\0':
+				//word = '\n'; //EOL marker
+				return STATUS_OK;
+			default:
+				if (word >= 'a' && word <= 'z') //uppercase
+				{
+					word -= 32;
+				}
+
+				if (word < 'A' || word > 'Z') //invalid recognized char
+				{
+					return STATUS_EXPECTED_COMMAND_LETTER;
+				}
+				break;
+			}
+
+			if (!parser_get_float(&word_val, &isinteger))
+			{
+				return STATUS_BAD_NUMBER_FORMAT;
+			}
 		}
 
 		uint8_t *word_group = &parser_group0;
@@ -672,11 +1020,12 @@ uint8_t parser_fetch_command(parser_state_t *new_state)
 				switch (code)
 				{
 				//codes with possible mantissa
+				case 5:
 				case 38:
 				case 59:
 				case 61:
 				case 92:
-					mantissa = (uint8_t)floorf((word_val - code) * 100.0f);
+					mantissa = (uint8_t)roundf((word_val - code) * 100.0f);
 					break;
 				default:
 					return STATUS_GCODE_COMMAND_VALUE_NOT_INTEGER;
@@ -691,6 +1040,7 @@ uint8_t parser_fetch_command(parser_state_t *new_state)
 			case 1:
 			case 2:
 			case 3:
+			case 5:
 			case 38: //check if 38.2
 			case 80:
 			case 81:
@@ -719,6 +1069,21 @@ uint8_t parser_fetch_command(parser_state_t *new_state)
 						return STATUS_INVALID_STATEMENT;
 					}
 				}
+				else if (code == 5)
+				{
+					//G5 = 18
+					//G5.1 = 19
+					code = 18;
+					switch (mantissa)
+					{
+					case 10:
+						code++;
+					case 0:
+						break;
+					default:
+						return STATUS_GCODE_UNSUPPORTED_COMMAND;
+					}
+				}
 				else if (code >= 80)
 				{
 					code -= 72;
@@ -1038,12 +1403,6 @@ uint8_t parser_fetch_command(parser_state_t *new_state)
 		case 'P':
 			word_group = &parser_word1;
 			word_group_val = GCODE_WORD_P;
-
-			if (word_val < 0)
-			{
-				return STATUS_NEGATIVE_VALUE;
-			}
-
 			new_state->words.p = word_val;
 			break;
 		case 'Q':
@@ -1167,6 +1526,13 @@ uint8_t parser_validate_command(parser_state_t *new_state)
 	{
 		switch (new_state->groups.nonmodal)
 		{
+		case 0:
+			//G4
+			if (new_state->words.p < 0)
+			{
+				return STATUS_NEGATIVE_VALUE;
+			}
+			break;
 		case 1:
 			//G10
 			//if no P or L is present
@@ -1354,7 +1720,7 @@ uint8_t parser_validate_command(parser_state_t *new_state)
 		}
 
 //group 5 - feed rate mode
-		if (new_state->groups.motion >= 1 && new_state->groups.motion <= 3)
+		if ((new_state->groups.motion >= 1 && new_state->groups.motion <= 3) || new_state->groups.motion >= 18)
 		{
 			if (new_state->groups.feedrate_mode == 0 && !CHECKFLAG(parser_word0, GCODE_WORD_F))
 			{
@@ -1367,6 +1733,54 @@ uint8_t parser_validate_command(parser_state_t *new_state)
 			}
 		}
 	}
+	//splines (G5, G5.1) are validated even if the motion mode is not explicitly declared in the line
+	if (new_state->groups.motion >= 18 && CHECKFLAG(parser_word0, GCODE_ALL_AXIS))
+	{
+		//splines are only supported in the XY plane
+		if (new_state->groups.plane != 0)
+		{
+			return STATUS_GCODE_UNSUPPORTED_COMMAND;
+		}
+
+		if (!CHECKFLAG(parser_word0, GCODE_XYPLANE_AXIS))
+		{
+			return STATUS_GCODE_NO_AXIS_WORDS_IN_PLANE;
+		}
+
+		if (CHECKFLAG(parser_word0, GCODE_ALL_AXIS & ~GCODE_XYPLANE_AXIS))
+		{
+			return STATUS_GCODE_AXIS_COMMAND_CONFLICT;
+		}
+
+		if (new_state->groups.motion == 18)
+		{
+			//P and Q are mandatory
+			if (CHECKFLAG(parser_word1, GCODE_WORD_P | GCODE_WORD_Q) != (GCODE_WORD_P | GCODE_WORD_Q))
+			{
+				return STATUS_GCODE_VALUE_WORD_MISSING;
+			}
+
+			//I and J must be both present or both omitted after a previous G5
+			switch (CHECKFLAG(parser_word1, GCODE_XYPLANE_AXIS))
+			{
+			case 0:
+				if (parser_state.groups.motion != 18)
+				{
+					return STATUS_GCODE_VALUE_WORD_MISSING;
+				}
+				break;
+			case GCODE_XYPLANE_AXIS:
+				break;
+			default:
+				return STATUS_GCODE_VALUE_WORD_MISSING;
+			}
+		}
+		else if (new_state->words.ijk[0] == 0 && new_state->words.ijk[1] == 0)
+		{
+			return STATUS_GCODE_NO_OFFSETS_IN_PLANE;
+		}
+	}
+
 //group 2 - plane selection (nothing to be checked)
 //group 3 - distance mode (nothing to be checked)
 
@@ -1422,7 +1836,10 @@ uint8_t parser_exec_command(parser_state_t *new_state)
 	float planner_last_pos[AXIS_COUNT];
 	planner_block_data_t block_data = {};
 
-	planner_get_position(planner_last_pos);
+	mc_get_position(planner_last_pos);
+#ifndef GCODE_IGNORE_LINE_NUMBERS
+	block_data.linenum = new_state->linenum;
+#endif
 
 	//RS274NGC v3 - 3.8 Order of Execution
 	//1. comment (ignored - already filtered)
@@ -1430,7 +1847,7 @@ uint8_t parser_exec_command(parser_state_t *new_state)
 	block_data.motion_mode = PLANNER_MOTION_MODE_FEED;
 	if (new_state->groups.feedrate_mode == 0)
 	{
-		if (new_state->groups.motion >= 1 && new_state->groups.motion <= 3)
+		if ((new_state->groups.motion >= 1 && new_state->groups.motion <= 3) || new_state->groups.motion >= 18)
 		{
 			block_data.motion_mode = PLANNER_MOTION_MODE_INVERSEFEED;
 		}
@@ -1504,6 +1921,13 @@ uint8_t parser_exec_command(parser_state_t *new_state)
 		for (uint8_t i = AXIS_COUNT; i != 0;)
 		{
 			i--;
+#ifdef AXIS_ROTARY
+			//the rotary axis is always in degrees
+			if (i == AXIS_ROTARY)
+			{
+				continue;
+			}
+#endif
 			new_state->words.xyzabc[i] *= 25.4f;
 		}
 
@@ -1527,6 +1951,13 @@ uint8_t parser_exec_command(parser_state_t *new_state)
 		{
 			new_state->words.r *= 25.4f;
 		}
+
+		//spline P and Q words are offsets
+		if (new_state->groups.motion == 18)
+		{
+			new_state->words.p *= 25.4f;
+			new_state->words.q *= 25.4f;
+		}
 	}
 
 	//13. cutter radius compensation on or off (G40, G41, G42) (not implemented yet)
@@ -1607,6 +2038,14 @@ uint8_t parser_exec_command(parser_state_t *new_state)
 		memcpy(&axis, &new_state->words.xyzabc, sizeof(axis));
 	}
 
+#ifdef AXIS_ROTARY
+	//absolute rotary targets are reached by the shortest path (incremental targets keep the commanded travel)
+	if (new_state->groups.distance_mode == 0 || new_state->groups.nonmodal == 5)
+	{
+		mc_rotary_shortest_path(axis);
+	}
+#endif
+
 	//set the initial feedrate to the maximum value
 	block_data.feed = FLT_MAX;
 
@@ -1631,6 +2070,7 @@ uint8_t parser_exec_command(parser_state_t *new_state)
 				i--;
 				parser_parameters.coord_sys[index][i] = new_state->words.xyzabc[i];
 			}
+			settings_save_parameters((const uint8_t *)&parser_parameters, sizeof(parser_parameters_t));
 			return STATUS_OK;
 		case 2: //G28
 		case 3: //G30
@@ -1642,10 +2082,16 @@ uint8_t parser_exec_command(parser_state_t *new_state)
 
 			if (new_state->groups.nonmodal == 2)
 			{
-				return mc_line((float *)&parser_parameters.g28home, block_data);
+				memcpy(&axis, &parser_parameters.g28home, sizeof(axis));
 			}
-
-			return mc_line((float *)&parser_parameters.g30home, block_data);
+			else
+			{
+				memcpy(&axis, &parser_parameters.g30home, sizeof(axis));
+			}
+#ifdef AXIS_ROTARY
+			mc_rotary_shortest_path(axis);
+#endif
+			return mc_line(axis, block_data);
 		case 9: //G92
 			for (uint8_t i = AXIS_COUNT; i != 0;)
 			{
@@ -1660,7 +2106,7 @@ uint8_t parser_exec_command(parser_state_t *new_state)
 		case 10: //G92.1
 			memset(&parser_parameters.g92offset, 0, sizeof(parser_parameters.g92offset));
 			//memset(&parser_offset_pos, 0, sizeof(parser_offset_pos));
-			settings_save(SETTINGS_PARSER_PARAMETERS_ADDRESS_OFFSET, (const uint8_t *)&parser_parameters, sizeof(parser_parameters_t));
+			settings_save_parameters((const uint8_t *)&parser_parameters, sizeof(parser_parameters_t));
 			parser_wco_counter = 0;
 			return STATUS_OK;
 		case 11: //G92.2
@@ -1670,7 +2116,7 @@ uint8_t parser_exec_command(parser_state_t *new_state)
 			return STATUS_OK;
 		case 12: //G92.3
 			//memcpy(&parser_offset_pos, &parser_parameters.g92offset, sizeof(parser_offset_pos));
-			settings_load(SETTINGS_PARSER_PARAMETERS_ADDRESS_OFFSET, (uint8_t *)&parser_parameters, sizeof(parser_parameters_t));
+			settings_load_parameters((uint8_t *)&parser_parameters, sizeof(parser_parameters_t));
 			parser_wco_counter = 0;
 			return STATUS_OK;
 		}
@@ -1687,7 +2133,8 @@ uint8_t parser_exec_command(parser_state_t *new_state)
 	}
 	else
 	{
-		block_data.feed = new_state->words.f;
+		//inverse time mode (the motion controller gets the duration of the motion in seconds)
+		block_data.feed = 1.0f / (new_state->words.f * MIN_SEC_MULT);
 	}
 
 	//if at least one axis was present in the command execute the active motion group
@@ -1783,6 +2230,38 @@ uint8_t parser_exec_command(parser_state_t *new_state)
 			}
 			parser_last_probe_ok = 1;
 			return STATUS_OK;
+		case 18: //G5
+		case 19: //G5.1
+		{
+			if (block_data.feed == 0)
+			{
+				return STATUS_FEED_NOT_SET;
+			}
+
+			float ctrl_pt0[2];
+			float ctrl_pt1[2];
+			if (new_state->groups.motion == 19)
+			{
+				ctrl_pt0[0] = planner_last_pos[AXIS_X] + new_state->words.ijk[0];
+				ctrl_pt0[1] = planner_last_pos[AXIS_Y] + new_state->words.ijk[1];
+				return spline_quadratic(axis, ctrl_pt0, AXIS_X, AXIS_Y, block_data);
+			}
+
+			//if I and J are omitted the first control point is the reflection of the last G5 second control point
+			if (!CHECKFLAG(parser_word1, GCODE_XYPLANE_AXIS))
+			{
+				new_state->words.ijk[0] = -parser_last_spline_pq[0];
+				new_state->words.ijk[1] = -parser_last_spline_pq[1];
+			}
+
+			ctrl_pt0[0] = planner_last_pos[AXIS_X] + new_state->words.ijk[0];
+			ctrl_pt0[1] = planner_last_pos[AXIS_Y] + new_state->words.ijk[1];
+			ctrl_pt1[0] = axis[AXIS_X] + new_state->words.p;
+			ctrl_pt1[1] = axis[AXIS_Y] + new_state->words.q;
+			parser_last_spline_pq[0] = new_state->words.p;
+			parser_last_spline_pq[1] = new_state->words.q;
+			return spline_cubic(axis, ctrl_pt0, ctrl_pt1, AXIS_X, AXIS_Y, block_data);
+		}
 		}
 	}
 
@@ -1830,4 +2309,5 @@ void parser_reset()
 	parser_state.groups.motion = 1; 												//G1
 	parser_state.groups.units = 1; 													//G21
 	memset(&parser_parameters.g92offset, 0, sizeof(parser_parameters.g92offset));	//G92.2
+	parser_clear();
 }
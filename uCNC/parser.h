@@ -31,11 +31,13 @@
 #include "machinedefs.h"
 
 void parser_init();
+void parser_clear();
 uint8_t parser_gcode_command();
 uint8_t parser_grbl_command();
 void parser_get_modes(uint8_t* modalgroups, uint16_t* feed, uint16_t* spindle);
 float* parser_get_coordsys(uint8_t system_num);
-bool parser_get_wco(float* axis);
+void parser_get_wco(float* axis);
+bool parser_get_wco_report();
 #ifdef USE_COOLANT
 void parser_update_coolant(uint8_t state);
 void parser_toogle_coolant(uint8_t state);
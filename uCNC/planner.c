@@ -28,6 +28,7 @@
 #include "settings.h"
 #include "planner.h"
 #include "interpolator.h"
+#include "kinematics.h"
 #include "utils.h"
 #include "io_control.h"
 #include "cnc.h"
@@ -109,6 +110,11 @@ bool planner_buffer_is_full()
 	return (planner_data_slots == 0);
 }
 
+uint8_t planner_get_buffer_freeslots()
+{
+	return planner_data_slots;
+}
+
 static inline void planner_buffer_clear()
 {
 	planner_data_write = 0;
@@ -259,7 +265,7 @@ float planner_update_spindle(bool update_outputs)
 		}
 		spindle = MIN(spindle, g_settings.spindle_max_rpm);
 		spindle = MAX(spindle, g_settings.spindle_min_rpm);
-		pwm = (uint8_t)roundf(255 * (spindle / g_settings.spindle_max_rpm));
+		pwm = (uint8_t)roundf(spindle * g_settings_derived.spindle_pwm_scale);
 		pwm = MAX(pwm, 1);
 	}
 	
@@ -358,6 +364,9 @@ void planner_add_line(float *target, planner_block_data_t block_data)
 	planner_spindle = planner_data[planner_data_write].spindle = block_data.spindle;
 	#endif
 	planner_data[planner_data_write].dwell = block_data.dwell;
+	#ifndef GCODE_IGNORE_LINE_NUMBERS
+	planner_data[planner_data_write].linenum = block_data.linenum;
+	#endif
 
 	planner_data[planner_data_write].distance = block_data.distance;
 	if(block_data.motion_mode == PLANNER_MOTION_MODE_NOMOTION)
@@ -383,9 +392,6 @@ void planner_add_line(float *target, planner_block_data_t block_data)
 		prev = planner_buffer_prev(planner_data_write); //BUFFER_PTR(planner_buffer, prev_index);
 	}
 
-	//calculates (given the motion direction), the maximum acceleration an feed allowed by the machine settings.
-	float rapid_feed = FLT_MAX;
-	planner_data[planner_data_write].acceleration = FLT_MAX;
 	for (uint8_t i = AXIS_COUNT; i != 0; )
 	{
 		i--;
@@ -393,41 +399,53 @@ void planner_add_line(float *target, planner_block_data_t block_data)
 		if (block_data.dir_vect[i] != 0)
 		{
 			block_data.dir_vect[i] *= inv_magn;
-			float dir_axis_abs = 1.0f/block_data.dir_vect[i];
 			if (block_data.dir_vect[i] < 0) //sets direction bits
 			{
 				SETBIT(planner_data[planner_data_write].dirbits, i);
-				dir_axis_abs = -dir_axis_abs;
 			}
 			
 			if (!planner_buffer_is_empty())
 			{
 				cos_theta += block_data.dir_vect[i] * prev_dir_vect[i];
 			}
-
-			//calcs maximum allowable speed for this diretion
-			float axis_speed = g_settings.max_feed_rate[i] * dir_axis_abs;
-			rapid_feed = MIN(rapid_feed, axis_speed);
-			//calcs maximum allowable acceleration for this direction
-			float axis_accel = g_settings.acceleration[i] * dir_axis_abs;
-			planner_data[planner_data_write].acceleration = MIN(planner_data[planner_data_write].acceleration, axis_accel);
 		}
-
 	}
 
-	planner_data[planner_data_write].accel_inv = 1.0f / planner_data[planner_data_write].acceleration;
-	//reduces target speed if exceeds the maximum allowed speed in the current direction
-	rapid_feed *= MIN_SEC_MULT; //converto to mm/s
-	if (block_data.feed > rapid_feed)
+	//calculates (given the motion direction), the maximum acceleration an feed allowed by the machine settings.
+	//the limit of each axis in the motion direction is max_feed / |dir|, so the inverse of the limit
+	//of the motion is the maximum of |dir| / max_feed (no divisions per axis)
+	//the direction is converted by the kinematics to the space where the limits apply (steppers in coreXY)
+	float limits_dir[AXIS_COUNT];
+	float rapid_feed_inv = 0;
+	float accel_inv = 0;
+	kinematics_apply_inverse_dir(block_data.dir_vect, limits_dir);
+	for (uint8_t i = AXIS_COUNT; i != 0; )
 	{
-		block_data.feed = rapid_feed;
+		i--;
+		float dir_axis_abs = fabsf(limits_dir[i]);
+		//calcs maximum allowable speed for this diretion
+		float axis_speed_inv = g_settings_derived.max_feed_rate_inv[i] * dir_axis_abs;
+		rapid_feed_inv = MAX(rapid_feed_inv, axis_speed_inv);
+		//calcs maximum allowable acceleration for this direction
+		float axis_accel_inv = g_settings_derived.acceleration_inv[i] * dir_axis_abs;
+		accel_inv = MAX(accel_inv, axis_accel_inv);
 	}
 
+	//a single division gives both the acceleration and the squared rapid feed
+	//	k = 1 / (accel_inv * rapid_feed_inv^2)
+	//	acceleration = k * rapid_feed_inv^2
+	//	rapid_feed^2 = k * accel_inv
+	float rapid_feed_inv_sqr = rapid_feed_inv * rapid_feed_inv;
+	float k = 1.0f / (accel_inv * rapid_feed_inv_sqr);
+	planner_data[planner_data_write].accel_inv = accel_inv;
+	planner_data[planner_data_write].acceleration = k * rapid_feed_inv_sqr;
+	planner_data[planner_data_write].rapid_feed_sqr = k * accel_inv;
+
 	//sets entry and max entry feeds as if it would start and finish from a stoped state
+	//reduces target speed if exceeds the maximum allowed speed in the current direction
 	planner_data[planner_data_write].entry_feed_sqr = 0;
-	planner_data[planner_data_write].feed_sqr = (block_data.feed * block_data.feed);
+	planner_data[planner_data_write].feed_sqr = MIN(block_data.feed * block_data.feed, planner_data[planner_data_write].rapid_feed_sqr);
 	planner_data[planner_data_write].entry_max_feed_sqr = planner_data[planner_data_write].feed_sqr;
-	planner_data[planner_data_write].rapid_feed_sqr = rapid_feed * rapid_feed;
 
 	//if more than one move stored cals juntion speeds and recalculates speed profiles
 	if (!planner_buffer_is_empty())
@@ -520,12 +538,20 @@ void planner_feed_ovr_reset()
 {
 	planner_overrides.feed_override = 100;
 	planner_ovr_counter = 0;
+	if (planner_overrides.overrides_enabled)
+	{
+		itp_update();
+	}
 }
 
 void planner_rapid_feed_ovr_reset()
 {
 	planner_overrides.rapid_feed_override = 100;
 	planner_ovr_counter = 0;
+	if (planner_overrides.overrides_enabled)
+	{
+		itp_update();
+	}
 }
 #ifdef USE_SPINDLE
 void planner_spindle_ovr_inc(float value)
@@ -543,17 +569,22 @@ void planner_spindle_ovr_reset()
 }
 #endif
 
+void planner_get_override_values(uint8_t *overrides)
+{
+	overrides[0] = planner_overrides.feed_override;
+	overrides[1] = planner_overrides.rapid_feed_override;
+	#ifdef USE_SPINDLE
+	overrides[2] = planner_overrides.spindle_override;
+	#else
+	overrides[2] = 0;
+	#endif
+}
+
 bool planner_get_overflows(uint8_t *overflows)
 {
 	if(!planner_ovr_counter)
 	{
-		overflows[0] = planner_overrides.feed_override;
-		overflows[1] = planner_overrides.rapid_feed_override;
-		#ifdef USE_SPINDLE
-		overflows[2] = planner_overrides.spindle_override;
-		#else
-		overflows[2] = 0;
-		#endif
+		planner_get_override_values(overflows);
 		planner_ovr_counter = STATUS_WCO_REPORT_MIN_FREQUENCY;
 		return true;
 	}
@@ -39,6 +39,9 @@ typedef struct
 	float spindle;
 	uint16_t dwell;
 	uint8_t motion_mode;
+	#ifndef GCODE_IGNORE_LINE_NUMBERS
+	uint32_t linenum;
+	#endif
 } planner_block_data_t;
 
 typedef struct
@@ -64,6 +67,9 @@ typedef struct
 	uint8_t coolant;
 	#endif
 	uint16_t dwell;
+	#ifndef GCODE_IGNORE_LINE_NUMBERS
+	uint32_t linenum;
+	#endif
 
 	bool optimal;
 } planner_block_t;
@@ -72,6 +78,7 @@ void planner_init();
 void planner_clear();
 bool planner_buffer_is_full();
 bool planner_buffer_is_empty();
+uint8_t planner_get_buffer_freeslots();
 planner_block_t *planner_get_block();
 float planner_get_block_exit_speed_sqr();
 float planner_get_block_top_speed();
@@ -99,6 +106,7 @@ void planner_spindle_ovr_reset();
 void planner_spindle_ovr_inc(float value);
 #endif
 
+void planner_get_override_values(uint8_t *overrides);
 bool planner_get_overflows(uint8_t *overflows);
 
 #endif
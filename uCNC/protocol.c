@@ -17,6 +17,7 @@
 
 #include "config.h"
 #include "utils.h"
+#include "grbl_interface.h"
 #include "settings.h"
 #include "serial.h"
 #include "interpolator.h"
@@ -24,6 +25,8 @@
 #include "parser.h"
 #include "planner.h"
 #include "cnc.h"
+#include "motion_control.h"
+#include "heightmap.h"
 #include "mcu.h"
 #include "protocol.h"
 
@@ -79,66 +82,74 @@ static uint8_t protocol_get_tools()
 	return result;
 }
 
-static void protocol_send_status_tail()
+/*
+	Status report formatting
+	The report is built in a scratch buffer in a single pass and only then sent
+	Numbers are printed in fixed point using integer math only
+*/
+//worst case of the status report length (coordinates with up to 6 integer digits)
+//with delta reports WCO, Ov and A can be sent in the same report
+#define PROTOCOL_STATUS_BUFFER_SIZE (110 + 24 * AXIS_COUNT)
+
+static uint8_t protocol_fmt_str(unsigned char *buffer, uint8_t i, const unsigned char *__s)
 {
-	float axis[AXIS_COUNT];
-	if(parser_get_wco(axis))
+	unsigned char c = rom_strptr(__s++);
+	while (c != 0)
 	{
-		serial_print_str(__romstr__("|WCO:"));
-		serial_print_fltarr(axis, AXIS_COUNT);
-		return;
+		buffer[i++] = c;
+		c = rom_strptr(__s++);
 	}
-	
-	uint8_t ovr[3];
-	if(planner_get_overflows(ovr))
-	{
-		serial_print_str(__romstr__("|Ov:"));
-		serial_print_int(ovr[0]);
-		serial_putc(',');
-		serial_print_int(ovr[1]);
-		serial_putc(',');
-		serial_print_int(ovr[2]);
-		uint8_t tools = protocol_get_tools();
-		if(tools)
+
+	return i;
+}
+
+//prints a coordinates array in mm (3 decimal places) or inches (4 decimal places)
+static uint8_t protocol_fmt_axis(unsigned char *buffer, uint8_t i, float *axis)
+{
+	for (uint8_t j = 0; j < AXIS_COUNT; j++)
+	{
+		if (j)
 		{
-			serial_print_str(__romstr__("|A:"));
-			if(CHECKFLAG(tools, 4))
-			{
-				serial_putc('S');
-			}
-			if(CHECKFLAG(tools, 8))
-			{
-				serial_putc('C');
-			}
-			if(CHECKFLAG(tools, 1))
-			{
-				serial_putc('F');
-			}
-			
-			if(CHECKFLAG(tools, 2))
-			{
-				serial_putc('M');
-			}
+			buffer[i++] = ',';
 		}
-		return;
+
+		i += serial_fmt_flt(&buffer[i], axis[j]);
 	}
+
+	return i;
 }
 
-void protocol_send_status()
+//pin flags of the Pn field (in the report order)
+#define PROTOCOL_PIN_ESTOP 1
+#define PROTOCOL_PIN_DOOR 2
+#define PROTOCOL_PIN_HOLD 4
+#define PROTOCOL_PIN_PROBE 8
+#define PROTOCOL_PIN_LIMITS_SHIFT 4
+
+//snapshot of the values of a status report
+//the last sent values are kept to allow auto reports to push only the fields that changed
+typedef struct
 {
+	uint8_t state;
+	uint8_t substate;
 	float axis[AXIS_COUNT];
+	float wco[AXIS_COUNT];
+	uint16_t freeslots[2];
+	uint32_t linenum;
+	int32_t feed;
+	int32_t spindle;
+	uint16_t pins;
+	uint8_t ovr[3];
+	uint8_t tools;
+} protocol_status_t;
 
-	//only send report when buffer is empty
-	//this prevents locks and stack overflow of the cnc_doevents()
-	if(!serial_tx_is_empty())
-	{
-		return;
-	}
+static protocol_status_t protocol_last_status;
+static bool protocol_last_status_valid;
+static uint32_t protocol_next_report;
 
-	itp_get_rt_position((float*)&axis);
-	float feed = itp_get_rt_feed() * 60.0f; //convert from mm/s to mm/m
-	float spindle = planner_update_spindle(false);
-	
+//returns the top most active exec state and the state sub code (for Hold and Door states)
+static uint8_t protocol_get_state(uint8_t *substate)
+{
 	uint8_t state = cnc_get_exec_state(0xFF);
 	uint8_t filter = 0x80;
 	while(!(state & filter) && filter)
@@ -148,136 +159,319 @@ void protocol_send_status()
 	
 	state &= filter;
 	
-	serial_putc('<');
 	switch(state)
 	{
-		case EXEC_ABORT:
-			serial_print_str(__romstr__("Abort"));
-			break;
 		case EXEC_DOOR:
-			serial_print_str(__romstr__("Door:"));
 			if(io_get_controls(SAFETY_DOOR_MASK))
 			{
-				
-				if(cnc_get_exec_state(EXEC_RUN))
-				{
-					serial_putc('2');
-				}
-				else
-				{
-					serial_putc('1');
-				}
+				*substate = (cnc_get_exec_state(EXEC_RUN)) ? '2' : '1';
 			}
 			else
 			{
-				if(cnc_get_exec_state(EXEC_RUN))
-				{
-					serial_putc('3');
-				}
-				else
-				{
-					serial_putc('0');
-				}
+				*substate = (cnc_get_exec_state(EXEC_RUN)) ? '3' : '0';
 			}
 			break;
+		case EXEC_HOLD:
+			*substate = (cnc_get_exec_state(EXEC_RUN)) ? '1' : '0';
+			break;
+		default:
+			*substate = 0;
+			break;
+	}
+	
+	return state;
+}
+
+static uint16_t protocol_get_pins()
+{
+	uint16_t pins = 0;
+	
+	if(io_get_controls(ESTOP_MASK))
+	{
+		pins |= PROTOCOL_PIN_ESTOP;
+	}
+	
+	if(io_get_controls(SAFETY_DOOR_MASK))
+	{
+		pins |= PROTOCOL_PIN_DOOR;
+	}
+	
+	if(io_get_controls(FHOLD_MASK))
+	{
+		pins |= PROTOCOL_PIN_HOLD;
+	}
+	
+	if(io_get_probe())
+	{
+		pins |= PROTOCOL_PIN_PROBE;
+	}
+	
+	pins |= ((uint16_t)io_get_limits(LIMITS_MASK) << PROTOCOL_PIN_LIMITS_SHIFT);
+	
+	return pins;
+}
+
+static bool protocol_axis_changed(float *axis, float *last)
+{
+	for(uint8_t j = AXIS_COUNT; j != 0;)
+	{
+		j--;
+		if(axis[j] != last[j])
+		{
+			return true;
+		}
+	}
+	
+	return false;
+}
+
+/*
+	Builds and sends the status report
+	On a delta report only the fields that changed since the last report are sent (the state is always sent)
+	Returns false if the report does not fit the TX buffer
+*/
+static bool protocol_send_status_report(bool delta)
+{
+	unsigned char buffer[PROTOCOL_STATUS_BUFFER_SIZE];
+	uint8_t i = 0;
+	protocol_status_t status;
+	//flags the fields sent in this report
+	bool send_axis, send_freeslots, send_linenum, send_feed, send_pins, send_wco, send_ovr, send_tools;
+
+	status.state = protocol_get_state(&status.substate);
+	itp_get_rt_position(status.axis);
+	parser_get_wco(status.wco);
+	if(!CHECKFLAG(g_settings.status_report_mask, REPORT_MASK_MPOS))
+	{
+		//work position = machine position - work coordinates offset
+		for(uint8_t j = AXIS_COUNT; j != 0;)
+		{
+			j--;
+			status.axis[j] -= status.wco[j];
+		}
+	}
+#ifdef AXIS_ROTARY
+	status.axis[AXIS_ROTARY] = mc_rotary_wrap(status.axis[AXIS_ROTARY]);
+#endif
+	//the motion control queue adds to the planner free blocks
+	status.freeslots[0] = planner_get_buffer_freeslots() + mc_get_buffer_freeslots();
+	status.freeslots[1] = serial_get_rx_freebytes();
+	#ifndef GCODE_IGNORE_LINE_NUMBERS
+	status.linenum = itp_get_rt_linenum();
+	#endif
+	status.feed = (int32_t)(itp_get_rt_feed() * 60.0f); //convert from mm/s to mm/m
+	#ifdef USE_SPINDLE
+	status.spindle = (int32_t)planner_update_spindle(false);
+	#else
+	status.spindle = 0;
+	#endif
+	status.pins = protocol_get_pins();
+	planner_get_override_values(status.ovr);
+	status.tools = protocol_get_tools();
+	
+	send_freeslots = CHECKFLAG(g_settings.status_report_mask, REPORT_MASK_BUFFER);
+	#ifndef GCODE_IGNORE_LINE_NUMBERS
+	send_linenum = CHECKFLAG(g_settings.status_report_mask, REPORT_MASK_LINENUM);
+	#else
+	status.linenum = 0;
+	send_linenum = false;
+	#endif
+	send_pins = CHECKFLAG(g_settings.status_report_mask, REPORT_MASK_PINS);
+	
+	if(delta)
+	{
+		send_axis = protocol_axis_changed(status.axis, protocol_last_status.axis);
+		send_freeslots = send_freeslots && (status.freeslots[0] != protocol_last_status.freeslots[0] || status.freeslots[1] != protocol_last_status.freeslots[1]);
+		send_linenum = send_linenum && (status.linenum != protocol_last_status.linenum);
+		send_feed = (status.feed != protocol_last_status.feed || status.spindle != protocol_last_status.spindle);
+		//an empty Pn field is sent if all pins went inactive
+		send_pins = send_pins && (status.pins != protocol_last_status.pins);
+		send_wco = protocol_axis_changed(status.wco, protocol_last_status.wco);
+		send_ovr = (status.ovr[0] != protocol_last_status.ovr[0] || status.ovr[1] != protocol_last_status.ovr[1] || status.ovr[2] != protocol_last_status.ovr[2]);
+		send_tools = (status.tools != protocol_last_status.tools);
+	}
+	else
+	{
+		send_axis = true;
+		send_feed = true;
+		send_pins = send_pins && status.pins;
+		//line number is only sent if the motion has one
+		send_linenum = send_linenum && status.linenum;
+		//WCO and overrides are only sent periodically
+		send_wco = parser_get_wco_report();
+		send_ovr = (!send_wco && planner_get_overflows(status.ovr));
+		send_tools = send_ovr && status.tools;
+	}
+	
+	buffer[i++] = '<';
+	switch(status.state)
+	{
+		case EXEC_ABORT:
+			i = protocol_fmt_str(buffer, i, __romstr__("Abort"));
+			break;
+		case EXEC_DOOR:
+			i = protocol_fmt_str(buffer, i, __romstr__("Door:"));
+			break;
 		case EXEC_NOHOME:
-			serial_print_str(__romstr__("Alarm"));
+			i = protocol_fmt_str(buffer, i, __romstr__("Alarm"));
 			break;
 		case EXEC_HOLD:
-			serial_print_str(__romstr__("Hold:"));
-			if(cnc_get_exec_state(EXEC_RUN))
-			{
-				serial_putc('1');
-			}
-			else
-			{
-				serial_putc('0');
-			}
+			i = protocol_fmt_str(buffer, i, __romstr__("Hold:"));
 			break;
 		case EXEC_HOMING:
-			serial_print_str(__romstr__("Home"));
+			i = protocol_fmt_str(buffer, i, __romstr__("Home"));
 			break;
 		case EXEC_JOG:
-			serial_print_str(__romstr__("Jog"));
+			i = protocol_fmt_str(buffer, i, __romstr__("Jog"));
 			break;
 		case EXEC_RUN:
-			serial_print_str(__romstr__("Run"));
+			i = protocol_fmt_str(buffer, i, __romstr__("Run"));
 			break;
 		default:
-			serial_print_str(__romstr__("Idle"));
+			i = protocol_fmt_str(buffer, i, __romstr__("Idle"));
 			break;
 	}
 	
-	serial_print_str(__romstr__("|MPos:"));
-	serial_print_fltarr(axis, AXIS_COUNT);
+	if(status.substate)
+	{
+		buffer[i++] = status.substate;
+	}
 	
-	#ifdef USE_SPINDLE
-	serial_print_str(__romstr__("|FS:"));
-	#else
-	serial_print_str(__romstr__("|F:"));
-	#endif
-	serial_print_int((uint16_t)feed);
-	#ifdef USE_SPINDLE
-	serial_putc(',');
-	serial_print_int((uint16_t)spindle);
-	#endif
+	if(send_axis)
+	{
+		if(CHECKFLAG(g_settings.status_report_mask, REPORT_MASK_MPOS))
+		{
+			i = protocol_fmt_str(buffer, i, __romstr__("|MPos:"));
+		}
+		else
+		{
+			i = protocol_fmt_str(buffer, i, __romstr__("|WPos:"));
+		}
+		i = protocol_fmt_axis(buffer, i, status.axis);
+	}
+	
+	if(send_freeslots)
+	{
+		i = protocol_fmt_str(buffer, i, __romstr__("|Bf:"));
+		i += serial_fmt_fixed(&buffer[i], status.freeslots[0], 0);
+		buffer[i++] = ',';
+		i += serial_fmt_fixed(&buffer[i], status.freeslots[1], 0);
+	}
+	
+	if(send_linenum)
+	{
+		i = protocol_fmt_str(buffer, i, __romstr__("|Ln:"));
+		i += serial_fmt_fixed(&buffer[i], (int32_t)status.linenum, 0);
+	}
+	
+	if(send_feed)
+	{
+		#ifdef USE_SPINDLE
+		i = protocol_fmt_str(buffer, i, __romstr__("|FS:"));
+		#else
+		i = protocol_fmt_str(buffer, i, __romstr__("|F:"));
+		#endif
+		i += serial_fmt_fixed(&buffer[i], status.feed, 0);
+		#ifdef USE_SPINDLE
+		buffer[i++] = ',';
+		i += serial_fmt_fixed(&buffer[i], status.spindle, 0);
+		#endif
+	}
 
-	if(io_get_controls(ESTOP_MASK | SAFETY_DOOR_MASK | FHOLD_MASK) | io_get_limits(LIMITS_MASK))
+	if(send_pins)
 	{
-		serial_print_str(__romstr__("|Pn:"));
+		i = protocol_fmt_str(buffer, i, __romstr__("|Pn:"));
 		
-		if(io_get_controls(ESTOP_MASK))
+		if(status.pins & PROTOCOL_PIN_ESTOP)
 		{
-			serial_putc('R');
+			buffer[i++] = 'R';
 		}
 		
-		if(io_get_controls(SAFETY_DOOR_MASK))
+		if(status.pins & PROTOCOL_PIN_DOOR)
 		{
-			serial_putc('D');
+			buffer[i++] = 'D';
 		}
 		
-		if(io_get_controls(FHOLD_MASK))
+		if(status.pins & PROTOCOL_PIN_HOLD)
 		{
-			serial_putc('H');
+			buffer[i++] = 'H';
 		}
 		
-		if(io_get_probe())
+		if(status.pins & PROTOCOL_PIN_PROBE)
 		{
-			serial_putc('P');
+			buffer[i++] = 'P';
 		}
 		
-		if(io_get_limits(LIMIT_X_MASK))
+		uint8_t limits = (uint8_t)(status.pins >> PROTOCOL_PIN_LIMITS_SHIFT);
+		
+		if(limits & LIMIT_X_MASK)
 		{
-			serial_putc('X');
+			buffer[i++] = 'X';
 		}
 		
-		if(io_get_limits(LIMIT_Y_MASK))
+		if(limits & LIMIT_Y_MASK)
 		{
-			serial_putc('Y');
+			buffer[i++] = 'Y';
 		}
 		
-		if(io_get_limits(LIMIT_Z_MASK))
+		if(limits & LIMIT_Z_MASK)
 		{
-			serial_putc('Z');
+			buffer[i++] = 'Z';
 		}
 		
-		if(io_get_limits(LIMIT_A_MASK))
+		if(limits & LIMIT_A_MASK)
 		{
-			serial_putc('A');
+			buffer[i++] = 'A';
 		}
 		
-		if(io_get_limits(LIMIT_B_MASK))
+		if(limits & LIMIT_B_MASK)
 		{
-			serial_putc('B');
+			buffer[i++] = 'B';
 		}
 		
-		if(io_get_limits(LIMIT_C_MASK))
+		if(limits & LIMIT_C_MASK)
 		{
-			serial_putc('C');
+			buffer[i++] = 'C';
 		}
 	}
 	
-	protocol_send_status_tail();
+	if(send_wco)
+	{
+		i = protocol_fmt_str(buffer, i, __romstr__("|WCO:"));
+		i = protocol_fmt_axis(buffer, i, status.wco);
+	}
+	
+	if(send_ovr)
+	{
+		i = protocol_fmt_str(buffer, i, __romstr__("|Ov:"));
+		i += serial_fmt_fixed(&buffer[i], status.ovr[0], 0);
+		buffer[i++] = ',';
+		i += serial_fmt_fixed(&buffer[i], status.ovr[1], 0);
+		buffer[i++] = ',';
+		i += serial_fmt_fixed(&buffer[i], status.ovr[2], 0);
+	}
+	
+	if(send_tools)
+	{
+		//an empty A field is sent if all accessories were turned off
+		i = protocol_fmt_str(buffer, i, __romstr__("|A:"));
+		if (CHECKFLAG(status.tools, 4))
+		{
+			buffer[i++] = 'S';
+		}
+		if (CHECKFLAG(status.tools, 8))
+		{
+			buffer[i++] = 'C';
+		}
+		if (CHECKFLAG(status.tools, 1))
+		{
+			buffer[i++] = 'F';
+		}
+		if (CHECKFLAG(status.tools, 2))
+		{
+			buffer[i++] = 'M';
+		}
+	}
 	/*
 	#ifdef __PERFSTATS__
 	uint16_t stepclocks = mcu_get_step_clocks();
@@ -285,8 +479,110 @@ void protocol_send_status()
 	protocol_printf(__romstr__("|Perf:%d,%d"), stepclocks, stepresetclocks);
 	#endif
 	*/
-	serial_putc('>');
-	procotol_send_newline();
+	buffer[i++] = '>';
+	buffer[i++] = '\r';
+	buffer[i++] = '\n';
+	
+	//the report is only sent if it fits the TX buffer without waiting
+	//a report larger than the whole buffer is only sent when the buffer is empty
+	if(!serial_tx_reserve(i) && !serial_tx_is_empty())
+	{
+		return false;
+	}
+	
+	for(uint8_t j = 0; j < i; j++)
+	{
+		serial_putc(buffer[j]);
+	}
+	
+	//updates the last sent values
+	protocol_last_status_valid = true;
+	protocol_last_status.state = status.state;
+	protocol_last_status.substate = status.substate;
+	if(send_axis)
+	{
+		memcpy(protocol_last_status.axis, status.axis, sizeof(status.axis));
+	}
+	if(send_freeslots)
+	{
+		protocol_last_status.freeslots[0] = status.freeslots[0];
+		protocol_last_status.freeslots[1] = status.freeslots[1];
+	}
+	if(send_linenum)
+	{
+		protocol_last_status.linenum = status.linenum;
+	}
+	if(send_feed)
+	{
+		protocol_last_status.feed = status.feed;
+		protocol_last_status.spindle = status.spindle;
+	}
+	if(send_pins || !status.pins)
+	{
+		protocol_last_status.pins = status.pins;
+	}
+	if(send_wco)
+	{
+		memcpy(protocol_last_status.wco, status.wco, sizeof(status.wco));
+	}
+	if(send_ovr)
+	{
+		memcpy(protocol_last_status.ovr, status.ovr, sizeof(status.ovr));
+	}
+	if(send_tools || (send_ovr && !status.tools))
+	{
+		protocol_last_status.tools = status.tools;
+	}
+	
+	return true;
+}
+
+bool protocol_send_status()
+{
+	return protocol_send_status_report(false);
+}
+
+void protocol_send_auto_status()
+{
+	if(!g_settings.status_report_interval)
+	{
+		return;
+	}
+	
+	uint32_t now = mcu_millis();
+	uint8_t substate;
+	uint8_t state = protocol_get_state(&substate);
+	
+	//pushes a report if the interval elapsed or immediately if the state changed
+	if((int32_t)(now - protocol_next_report) >= 0 || state != protocol_last_status.state || substate != protocol_last_status.substate)
+	{
+		//the first pushed report is a full report
+		if(protocol_send_status_report(protocol_last_status_valid))
+		{
+			protocol_next_report = now + g_settings.status_report_interval;
+		}
+	}
+}
+
+void protocol_send_frame_acks()
+{
+	uint8_t seq;
+	
+	if(serial_get_frame_ack(&seq))
+	{
+		serial_print_str(__romstr__("[ACK:"));
+		serial_print_int(seq);
+		serial_putc(']');
+		procotol_send_newline();
+	}
+	
+	if(serial_get_frame_nak(&seq))
+	{
+		serial_print_str(__romstr__("[NAK:"));
+		serial_print_int(seq);
+		serial_putc(']');
+		procotol_send_newline();
+	}
 }
 
 void protocol_send_gcode_coordsys()
@@ -348,7 +644,19 @@ void protocol_send_gcode_modes()
 	for(uint8_t i = 0; i < 5; i++)
 	{
 		serial_putc('G');
-		serial_print_int((int16_t)modalgroups[i]);
+		//the splines are stored as the motion modes 18 (G5) and 19 (G5.1)
+		if(i == 0 && (modalgroups[0] == 18 || modalgroups[0] == 19))
+		{
+			serial_putc('5');
+			if(modalgroups[0] == 19)
+			{
+				serial_print_str(__romstr__(".1"));
+			}
+		}
+		else
+		{
+			serial_print_int((int16_t)modalgroups[i]);
+		}
 		serial_putc(' ');
 	}
 	
@@ -374,6 +682,44 @@ void protocol_send_gcode_modes()
 	procotol_send_newline();
 }
 
+#ifdef ENABLE_CHECKMODE_SIMULATION
+void protocol_send_sim_stats()
+{
+	float time;
+	float max_feed;
+	uint16_t stops;
+
+	itp_get_sim_stats(&time, &max_feed, &stops);
+	serial_print_str(__romstr__("[SIM:T:"));
+	serial_print_fixed((int32_t)(time * 1000.0f), 3);
+	serial_print_str(__romstr__(",F:"));
+	serial_print_int((int32_t)(max_feed * 60.0f)); //convert from mm/s to mm/m
+	serial_print_str(__romstr__(",S:"));
+	serial_print_int(stops);
+	serial_putc(']');
+	procotol_send_newline();
+}
+#endif
+
+#ifdef ENABLE_HEIGHTMAP
+void protocol_send_heightmap()
+{
+	float point[3];
+	if(!hmap_is_active())
+	{
+		return;
+	}
+
+	for(uint8_t i = 0; hmap_get_point(i, point); i++)
+	{
+		serial_print_str(__romstr__("[HMAP:"));
+		serial_print_fltarr(point, 3);
+		serial_putc(']');
+		procotol_send_newline();
+	}
+}
+#endif
+
 static void protocol_send_gcode_setting_line_int(uint8_t setting, uint16_t value)
 {
 	serial_putc('$');
@@ -402,6 +748,7 @@ void protocol_send_gcode_settings()
 	protocol_send_gcode_setting_line_int(7, g_settings.control_invert_mask);
 	protocol_send_gcode_setting_line_int(10, g_settings.status_report_mask);
 	protocol_send_gcode_setting_line_flt(12, g_settings.arc_tolerance);
+	protocol_send_gcode_setting_line_int(15, g_settings.status_report_interval);
 	protocol_send_gcode_setting_line_int(20, g_settings.soft_limits_enabled);
 	protocol_send_gcode_setting_line_int(21, g_settings.hard_limits_enabled);
 	protocol_send_gcode_setting_line_int(22, g_settings.homing_enabled);
@@ -409,8 +756,25 @@ void protocol_send_gcode_settings()
 	protocol_send_gcode_setting_line_flt(24, g_settings.homing_slow_feed_rate);
 	protocol_send_gcode_setting_line_flt(25, g_settings.homing_fast_feed_rate);
 	protocol_send_gcode_setting_line_flt(27, g_settings.homing_offset);
+	#if(MACHINE_KINEMATICS == MACHINE_DELTA)
+	protocol_send_gcode_setting_line_flt(28, g_settings.delta_arm_length);
+	protocol_send_gcode_setting_line_flt(29, g_settings.delta_radius);
+	#elif(MACHINE_KINEMATICS == MACHINE_SCARA)
+	protocol_send_gcode_setting_line_flt(28, g_settings.scara_arm_length[0]);
+	protocol_send_gcode_setting_line_flt(29, g_settings.scara_arm_length[1]);
+	#endif
 	protocol_send_gcode_setting_line_flt(30, g_settings.spindle_max_rpm);
 	protocol_send_gcode_setting_line_flt(31, g_settings.spindle_min_rpm);
+	#if(MACHINE_KINEMATICS == MACHINE_SCARA)
+	protocol_send_gcode_setting_line_flt(36, g_settings.scara_home_angle[0]);
+	protocol_send_gcode_setting_line_flt(37, g_settings.scara_home_angle[1]);
+	#endif
+	#ifdef ENABLE_SKEW_COMPENSATION
+	for(uint8_t i = 0; i < 3; i++)
+	{
+		protocol_send_gcode_setting_line_flt(40 + i, g_settings.skew_factor[i]);
+	}
+	#endif
 	
 	for(uint8_t i = 0; i < AXIS_COUNT; i++)
 	{
@@ -431,4 +795,11 @@ void protocol_send_gcode_settings()
 	{
 		protocol_send_gcode_setting_line_flt(130 + i , g_settings.max_distance[i]);
 	}
+	
+	#ifdef ENABLE_SKEW_COMPENSATION
+	for(uint8_t i = 0; i < 3; i++)
+	{
+		protocol_send_gcode_setting_line_flt(140 + i, g_settings.axis_scale[i]);
+	}
+	#endif
 }
@@ -21,15 +21,24 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdarg.h>
+#include "config.h"
 
 bool protocol_is_busy();
 void protocol_send_ok();
 void protocol_send_error(uint8_t error);
 void protocol_send_alarm(uint8_t alarm);
-void protocol_send_status();
+bool protocol_send_status();
+void protocol_send_auto_status();
+void protocol_send_frame_acks();
 void protocol_send_string(const unsigned char* __s);
 void protocol_send_gcode_coordsys();
 void protocol_send_gcode_modes();
 void protocol_send_gcode_settings();
+#ifdef ENABLE_CHECKMODE_SIMULATION
+void protocol_send_sim_stats();
+#endif
+#ifdef ENABLE_HEIGHTMAP
+void protocol_send_heightmap();
+#endif
 
 #endif
@@ -24,33 +24,115 @@
 #include "cnc.h"
 #include "serial.h"
 #include "utils.h"
+#include "binary_gcode.h"
+#include "storage.h"
 
-#include <math.h>
-
-#define RX_BUFFER_SIZE 128
 #define TX_BUFFER_SIZE 112
 
+#if(RX_BUFFER_SIZE > 255)
+typedef uint16_t serial_rx_index_t;
+#else
+typedef uint8_t serial_rx_index_t;
+#endif
+#define RX_LINE_MASK (RX_LINE_COUNT - 1)
+
+#if(RX_LINE_COUNT < 4 || RX_LINE_COUNT > 32 || (RX_LINE_COUNT & RX_LINE_MASK))
+#error "RX_LINE_COUNT must be a power of 2 between 4 and 32"
+#endif
+
+#if(RX_LINE_COUNT > 16)
+typedef uint32_t serial_rx_line_mask_t;
+#elif(RX_LINE_COUNT > 8)
+typedef uint16_t serial_rx_line_mask_t;
+#else
+typedef uint8_t serial_rx_line_mask_t;
+#endif
 
 static unsigned char serial_rx_buffer[RX_BUFFER_SIZE];
-volatile static uint8_t serial_rx_count;
-volatile static uint8_t serial_rx_read;
-volatile static uint8_t serial_rx_write;
+static serial_rx_index_t serial_rx_read;
+volatile static serial_rx_index_t serial_rx_write;
+/*
+	Ring with the end offsets of the commands in the RX buffer
+	The entry before serial_rx_line_read holds the start of the oldest command (the buffer is free before it)
+	This way the ISR only reads 8 bit indexes written by the main loop
+*/
+volatile static serial_rx_index_t serial_rx_line_end[RX_LINE_COUNT];
+volatile static uint8_t serial_rx_line_read;
+volatile static uint8_t serial_rx_line_write;
+//ring entries that hold several lines (appended when the ring was full)
+//only the ISR writes it (a reused entry is cleared when the command is committed)
+volatile static serial_rx_line_mask_t serial_rx_line_merged;
+//signals that the command being received did not fit in the RX buffer and is being discarded
+static bool serial_rx_overflow;
+//number of bytes left to complete the binary frame being received (the length byte can declare up to 255 bytes)
+volatile static uint16_t serial_rx_frame;
+#define SERIAL_RX_FRAME_LENGTH 0xFFFF
+//time of the last byte of the binary frame being received and escape state of the next byte
+static uint32_t serial_rx_frame_time;
+static bool serial_rx_frame_escape;
+//signals that the current command was only partially read
+static bool serial_rx_partial;
+
+//framed streaming mode receiver
+#define SERIAL_FRAME_SOH 0
+#define SERIAL_FRAME_SEQ 1
+#define SERIAL_FRAME_LEN 2
+#define SERIAL_FRAME_PAYLOAD 3
+#define SERIAL_FRAME_CRC_MSB 4
+#define SERIAL_FRAME_CRC_LSB 5
+
+typedef struct
+{
+	bool enabled;
+	uint8_t state;
+	uint8_t seq;
+	uint8_t len;
+	uint8_t pos;
+	uint16_t crc;
+	//payload is written ahead of the RX buffer write index and is only commited if the frame is valid
+	serial_rx_index_t write;
+	bool binary;
+	bool comment;
+	bool rejected;
+	//next expected sequence number
+	uint8_t expected;
+	//acknowledge state read by the main loop
+	volatile uint8_t ack;
+	volatile bool ack_pending;
+	volatile bool nak_pending;
+	bool nak_sent;
+} serial_frame_t;
+
+static serial_frame_t serial_frame;
 
 static unsigned char serial_tx_buffer[TX_BUFFER_SIZE];
 volatile static uint8_t serial_tx_read;
-volatile static uint8_t serial_tx_write;
-volatile static uint8_t serial_tx_count;
+static uint8_t serial_tx_write;
+//end of the committed data (only complete messages are sent by the ISR)
+volatile static uint8_t serial_tx_end;
 
 void serial_init()
 {
 	#ifdef FORCE_GLOBALS_TO_0
 	serial_rx_write = 0;
 	serial_rx_read = 0;
-	serial_rx_count = 0;
+	serial_rx_line_read = 0;
+	serial_rx_line_write = 0;
+	for(uint8_t i = 0; i < RX_LINE_COUNT; i++)
+	{
+		serial_rx_line_end[i] = 0;
+	}
+	serial_rx_line_merged = 0;
+	serial_rx_overflow = false;
+	serial_rx_frame = 0;
+	serial_rx_frame_escape = false;
+	serial_rx_partial = false;
 	
 	serial_tx_read = 0;
 	serial_tx_write = 0;
-	serial_tx_count = 0;
+	serial_tx_end = 0;
+	
+	memset(&serial_frame, 0, sizeof(serial_frame_t));
 	
 	//resets buffers
 	memset(&serial_rx_buffer, 0, sizeof(serial_rx_buffer));
@@ -60,23 +142,77 @@ void serial_init()
 
 void serial_clear()
 {
+	//a soft reset always returns to line mode
+	memset(&serial_frame, 0, sizeof(serial_frame_t));
+
 	serial_rx_write = 0;
 	serial_rx_read = 0;
-	serial_rx_count = 0;
+	serial_rx_line_read = 0;
+	serial_rx_line_write = 0;
+	for(uint8_t i = 0; i < RX_LINE_COUNT; i++)
+	{
+		serial_rx_line_end[i] = 0;
+	}
+	serial_rx_line_merged = 0;
+	serial_rx_overflow = false;
+	serial_rx_frame = 0;
+	serial_rx_frame_escape = false;
+	serial_rx_partial = false;
 	
 	serial_tx_read = 0;
 	serial_tx_write = 0;
-	serial_tx_count = 0;
+	serial_tx_end = 0;
 }
 
 bool serial_rx_is_empty()
 {
-	return (!serial_rx_count);
+	#ifdef ENABLE_PROGRAM_STORAGE
+	//while a stored program is running the commands are read from the storage
+	if(storage_is_running())
+	{
+		return storage_is_empty();
+	}
+	#endif
+	
+	return (serial_rx_line_read == serial_rx_line_write);
+}
+
+uint16_t serial_get_rx_freebytes()
+{
+	uint8_t tail = (serial_rx_line_read - 1) & RX_LINE_MASK;
+	serial_rx_index_t read = serial_rx_line_end[tail];
+	serial_rx_index_t write = serial_rx_write;
+	//one byte is always kept free to differentiate a full from an empty buffer
+	serial_rx_index_t used = (write >= read) ? (write - read) : (RX_BUFFER_SIZE - read + write);
+	return (RX_BUFFER_SIZE - 1 - used);
+}
+
+//moves the read index to the start of the next command
+static void serial_rx_next_cmd()
+{
+	uint8_t line = serial_rx_line_read;
+	serial_rx_read = serial_rx_line_end[line];
+	serial_rx_line_read = (line + 1) & RX_LINE_MASK;
+	serial_rx_partial = false;
 }
 
 bool serial_tx_is_empty()
 {
-	return (!serial_tx_count);
+	return (serial_tx_read == serial_tx_end);
+}
+
+static uint8_t serial_get_tx_freebytes()
+{
+	uint8_t read = serial_tx_read;
+	uint8_t write = serial_tx_write;
+	//one byte is always kept free to differentiate a full from an empty buffer
+	return ((read > write) ? (read - write - 1) : (TX_BUFFER_SIZE - 1 - write + read));
+}
+
+bool serial_tx_reserve(uint8_t len)
+{
+	//only the main loop writes to the buffer so the free space can only grow after this check
+	return (serial_get_tx_freebytes() >= len);
 }
 
 unsigned char serial_getc()
@@ -86,11 +222,25 @@ unsigned char serial_getc()
 	#endif
 	unsigned char c = '\0';
 	
-	if(!serial_rx_count)
+	#ifdef ENABLE_PROGRAM_STORAGE
+	if(storage_is_running())
+	{
+		return storage_getc();
+	}
+	#endif
+	
+	if(serial_rx_line_read == serial_rx_line_write)
 	{
 		return c;
 	}
 	
+	//empty command left in place of a line that did not fit in the RX buffer
+	if(serial_rx_read == serial_rx_line_end[serial_rx_line_read])
+	{
+		serial_rx_next_cmd();
+		return '\n';
+	}
+	
 	#ifdef ECHO_CMD
 	if(!echo)
 	{
@@ -103,7 +253,6 @@ unsigned char serial_getc()
 	switch(c)
 	{
 		case '\n':
-			serial_rx_count--;
 			#ifdef ECHO_CMD
 			echo = false;
 		    serial_print_str(__romstr__("]\r\n"));
@@ -122,12 +271,34 @@ unsigned char serial_getc()
 		serial_rx_read = 0;
 	}
 	
+	if(serial_rx_read == serial_rx_line_end[serial_rx_line_read])
+	{
+		serial_rx_next_cmd();
+	}
+	else
+	{
+		//an entry can hold several lines (when the ring was full)
+		serial_rx_partial = (c != '\n');
+	}
+	
 	return c;
 }
 
 unsigned char serial_peek()
 {
-	return ((serial_rx_count != 0) ? serial_rx_buffer[serial_rx_read] : 0);
+	#ifdef ENABLE_PROGRAM_STORAGE
+	if(storage_is_running())
+	{
+		return storage_peek();
+	}
+	#endif
+	
+	if(serial_rx_line_read == serial_rx_line_write)
+	{
+		return 0;
+	}
+	
+	return ((serial_rx_read != serial_rx_line_end[serial_rx_line_read]) ? serial_rx_buffer[serial_rx_read] : SERIAL_RX_OVERFLOW);
 }
 
 void serial_inject_cmd(const unsigned char* __s)
@@ -139,33 +310,103 @@ void serial_inject_cmd(const unsigned char* __s)
 	} while(c != 0);
 }
 
+uint8_t serial_get_frame(uint8_t* buffer, uint8_t size)
+{
+	#ifdef ENABLE_PROGRAM_STORAGE
+	if(storage_is_running())
+	{
+		return storage_get_frame(buffer, size);
+	}
+	#endif
+	
+	//discards the opcode (already read by the parser)
+	if(++serial_rx_read == RX_BUFFER_SIZE)
+	{
+		serial_rx_read = 0;
+	}
+
+	uint8_t len = serial_rx_buffer[serial_rx_read];
+	if(++serial_rx_read == RX_BUFFER_SIZE)
+	{
+		serial_rx_read = 0;
+	}
+	
+	//copies the payload and the CRC
+	//any byte value is valid inside the frame so the bytes are not checked for the end of line
+	for(uint8_t i = 0; i <= len && i < size; i++)
+	{
+		buffer[i] = serial_rx_buffer[serial_rx_read];
+		if(++serial_rx_read == RX_BUFFER_SIZE)
+		{
+			serial_rx_read = 0;
+		}
+	}
+	
+	//the frame counts has a single command
+	if(serial_rx_read == serial_rx_line_end[serial_rx_line_read])
+	{
+		serial_rx_next_cmd();
+	}
+	else
+	{
+		serial_rx_partial = false;
+	}
+	
+	return len;
+}
+
 void serial_discard_cmd()
 {
-	if(serial_rx_count != 0)
+	#ifdef ENABLE_PROGRAM_STORAGE
+	if(storage_is_running())
 	{
-		while(serial_getc() != '\n');
+		storage_discard_cmd();
+		return;
+	}
+	#endif
+	
+	//only discards if the command was not read to the end
+	if(serial_rx_line_read != serial_rx_line_write && serial_rx_partial)
+	{
+		#ifndef ECHO_CMD
+		//an entry with a single line is skipped at once (the echo needs the remaining chars)
+		if(!(serial_rx_line_merged & ((serial_rx_line_mask_t)1 << serial_rx_line_read)))
+		{
+			serial_rx_next_cmd();
+			return;
+		}
+		#endif
+		
+		//reads up to the end of the line (the next lines of the same entry are kept)
+		while(serial_rx_partial)
+		{
+			serial_getc();
+		}
 	}
 }
 
 void serial_putc(unsigned char c)
 {
-	while((serial_tx_write == serial_tx_read) && (serial_tx_count != 0))
+	//while buffer is full waits for the ISR to send some chars
+	//the main loop (cnc_doevents) is never called from here to prevent reentrancy
+	while(!serial_get_tx_freebytes())
 	{
+		//commits the partial message to allow messages larger than the buffer
+		serial_tx_end = serial_tx_write;
 		mcu_start_send();
-		cnc_doevents();	
-	} //while buffer is full 
+	}
 	
 	serial_tx_buffer[serial_tx_write] = c;
-	serial_tx_write++;
-	if(c == '\n')
+	if(++serial_tx_write == TX_BUFFER_SIZE)
 	{
-		serial_tx_count++;
-		mcu_start_send();
+		serial_tx_write = 0;
 	}
-
-	if(serial_tx_write == TX_BUFFER_SIZE)
+	
+	//commits the message
+	if(c == '\n')
 	{
-		serial_tx_write = 0;
+		serial_tx_end = serial_tx_write;
+		mcu_start_send();
 	}
 }
 
@@ -179,92 +420,107 @@ void serial_print_str(const unsigned char* __s)
 	} while(c != 0);
 }
 
-void serial_print_int(uint16_t num)
+/*
+	Number formatting
+	All numbers are printed from a scaled integer (fixed point) using only integer math
+	Floats are converted once to um (or 0.1um/0.0001inch when reporting in inches) and then printed as fixed point
+*/
+
+//divides by 10 using only shifts and adds (no hardware divide or 32bit multiply needed)
+static uint32_t serial_divu10(uint32_t n, uint8_t* rem)
 {
-	if (num == 0)
+	uint32_t q = (n >> 1) + (n >> 2);
+	q += (q >> 4);
+	q += (q >> 8);
+	q += (q >> 16);
+	q >>= 3;
+	uint8_t r = (uint8_t)(n - (((q << 2) + q) << 1));
+	if(r > 9)
 	{
-		serial_putc('0');
-		return;
+		q++;
+		r -= 10;
 	}
 	
-	unsigned char buffer[6];
+	*rem = r;
+	return q;
+}
+
+uint8_t serial_fmt_fixed(unsigned char* buffer, int32_t num, uint8_t decimals)
+{
+	unsigned char digits[10];
 	uint8_t i = 0;
+	uint8_t n = 0;
+	uint32_t value = (uint32_t)num;
 	
-	while (num > 0)
+	if(num < 0)
 	{
-		uint8_t digit = num % 10;
-		num = ((((uint32_t)num * (UINT16_MAX/10))>>16) + ((digit!=0) ? 0 : 1)); //same has divide by 10 but faster
-		buffer[i++] = digit;
-		/*buffer[i++] = num % 10;
-		num /= 10;*/
+		buffer[i++] = '-';
+		value = -value;
 	}
 	
+	//at least one integer digit is printed
 	do
 	{
-		i--;
-		serial_putc('0' + buffer[i]);
-	}while(i);
-}
-/*
-void serial_print_int(uint16_t num)
-{
-	char buffer[6];
-	sprintf(buffer, MSG_INT, num);
+		uint8_t digit;
+		value = serial_divu10(value, &digit);
+		digits[n++] = '0' + digit;
+	} while(value || n <= decimals);
 	
-	uint8_t i = 0;
 	do
 	{
-		serial_putc(buffer[i]);
-		i++;
-	} while(buffer[i] != 0);	
-
-}*/
+		n--;
+		buffer[i++] = digits[n];
+		if(n == decimals && n)
+		{
+			buffer[i++] = '.';
+		}
+	} while(n);
+	
+	return i;
+}
 
-void serial_print_flt(float num)
+uint8_t serial_fmt_flt(unsigned char* buffer, float num)
 {
+	uint8_t decimals = 3;
+	
 	if(g_settings.report_inches)
 	{
-		num *= MM_INCH_MULT;
+		num *= (MM_INCH_MULT * 10000.0f);
+		decimals = 4;
 	}
-	
-	if(num < 0)
+	else
 	{
-		serial_putc('-');
-		num = -num;
+		num *= 1000.0f;
 	}
 	
-	uint16_t digits = (uint16_t)floorf(num);
-	serial_print_int(digits);
-	serial_putc('.');
-	num -= digits;
-	
-	num *= 1000;
-	digits = (uint16_t)roundf(num);
-	
-	if(g_settings.report_inches)
-	{
-		if(digits<10000)
-		{
-			serial_putc('0');
-		}
-		
-		if(digits<1000)
-		{
-			serial_putc('0');
-		}
-	}
+	return serial_fmt_fixed(buffer, (int32_t)((num < 0) ? (num - 0.5f) : (num + 0.5f)), decimals);
+}
+
+void serial_print_fixed(int32_t num, uint8_t decimals)
+{
+	unsigned char buffer[SERIAL_FMT_BUFFER_SIZE];
+	uint8_t len = serial_fmt_fixed(buffer, num, decimals);
 	
-	if(digits<100)
+	for(uint8_t i = 0; i < len; i++)
 	{
-		serial_putc('0');
+		serial_putc(buffer[i]);
 	}
+}
+
+void serial_print_int(int32_t num)
+{
+	serial_print_fixed(num, 0);
+}
+
+void serial_print_flt(float num)
+{
+	unsigned char buffer[SERIAL_FMT_BUFFER_SIZE];
+	uint8_t len = serial_fmt_flt(buffer, num);
 	
-	if(digits<10)
+	for(uint8_t i = 0; i < len; i++)
 	{
-		serial_putc('0');
+		serial_putc(buffer[i]);
 	}
-
-	serial_print_int(digits);
 }
 
 void serial_print_intarr(uint16_t* arr, uint8_t count)
@@ -296,9 +552,44 @@ void serial_print_fltarr(float* arr, uint8_t count)
 
 }
 
+void serial_set_framed_mode(bool enable)
+{
+	//on disable the pending acknowledges are kept to be sent
+	if(enable)
+	{
+		memset(&serial_frame, 0, sizeof(serial_frame_t));
+	}
+	
+	serial_frame.enabled = enable;
+}
+
+bool serial_get_frame_ack(uint8_t* seq)
+{
+	if(!serial_frame.ack_pending)
+	{
+		return false;
+	}
+	
+	serial_frame.ack_pending = false;
+	*seq = serial_frame.ack;
+	return true;
+}
+
+bool serial_get_frame_nak(uint8_t* seq)
+{
+	if(!serial_frame.nak_pending)
+	{
+		return false;
+	}
+	
+	serial_frame.nak_pending = false;
+	*seq = serial_frame.expected;
+	return true;
+}
+
 void serial_flush()
 {
-	while(serial_tx_count)
+	while(!serial_tx_is_empty())
 	{
 		mcu_start_send();
 		cnc_doevents();
@@ -307,12 +598,331 @@ void serial_flush()
 
 //ISR
 
+//stores a char of the command being received
+//the last char of the command can use the byte that is always kept free for the end of the command
+static void serial_rx_putc(unsigned char c, bool last)
+{
+	if(serial_rx_overflow)
+	{
+		return;
+	}
+	
+	if(serial_get_rx_freebytes() < (last ? 1 : 2))
+	{
+		//the command is discarded
+		serial_rx_overflow = true;
+		return;
+	}
+	
+	serial_rx_buffer[serial_rx_write] = c;
+	if(++serial_rx_write == RX_BUFFER_SIZE)
+	{
+		serial_rx_write = 0;
+	}
+}
+
+//commits the command that was received
+static void serial_rx_end_cmd()
+{
+	uint8_t line = serial_rx_line_write;
+	serial_rx_index_t start = serial_rx_line_end[(line - 1) & RX_LINE_MASK];
+	
+	/*
+		No room for another command in the ring (many short lines fill the ring before the buffer)
+		The command is appended to the last queued command so that it still gets a response
+		The last queued command is never being read because the ring has more than 2 entries
+	*/
+	if(line == ((serial_rx_line_read - 1) & RX_LINE_MASK))
+	{
+		uint8_t last = (line - 1) & RX_LINE_MASK;
+		//an empty command (overflow) can't be extended
+		bool empty = (start == serial_rx_line_end[(last - 1) & RX_LINE_MASK]);
+		if(serial_rx_overflow || empty)
+		{
+			//the host already lost sync and the command is also discarded
+			//the discarded commands are replaced by lines with the overflow mark (if they fit)
+			serial_rx_write = start;
+			serial_rx_overflow = false;
+			if(empty)
+			{
+				serial_rx_putc(SERIAL_RX_OVERFLOW, false);
+				serial_rx_putc('\n', false);
+			}
+			serial_rx_putc(SERIAL_RX_OVERFLOW, false);
+			serial_rx_putc('\n', true);
+			if(serial_rx_overflow)
+			{
+				serial_rx_write = start;
+				serial_rx_overflow = false;
+				return;
+			}
+		}
+		
+		serial_rx_line_merged |= ((serial_rx_line_mask_t)1 << last);
+		serial_rx_line_end[last] = serial_rx_write;
+		return;
+	}
+	
+	if(serial_rx_overflow)
+	{
+		//an empty command is stored in the place of the discarded one to report the error
+		serial_rx_write = start;
+		serial_rx_overflow = false;
+	}
+	
+	serial_rx_line_merged &= ~((serial_rx_line_mask_t)1 << line);
+	serial_rx_line_end[line] = serial_rx_write;
+	serial_rx_line_write = (line + 1) & RX_LINE_MASK;
+}
+
+//updates the CRC16-CCITT (poly 0x1021) with the next byte
+static uint16_t serial_crc16(uint8_t c, uint16_t crc)
+{
+	crc = (crc >> 8) | (crc << 8);
+	crc ^= c;
+	crc ^= (crc & 0xFF) >> 4;
+	crc ^= (crc << 12);
+	crc ^= ((crc & 0xFF) << 5);
+	return crc;
+}
+
+//stores a payload byte ahead of the RX buffer write index
+static void serial_rx_frame_putc(unsigned char c)
+{
+	serial_rx_buffer[serial_frame.write] = c;
+	if(++serial_frame.write == RX_BUFFER_SIZE)
+	{
+		serial_frame.write = 0;
+	}
+}
+
+static void serial_rx_frame_payload(unsigned char c)
+{
+	//the first byte tells if the payload is a binary gcode frame
+	if(!serial_frame.pos)
+	{
+		serial_frame.binary = BINARY_GCODE_IS_FRAME(c);
+	}
+	
+	serial_frame.pos++;
+	if(serial_frame.rejected)
+	{
+		return;
+	}
+	
+	if(serial_frame.binary)
+	{
+		//binary gcode frames are stored without any filtering
+		serial_rx_frame_putc(c);
+		return;
+	}
+	
+	//ASCII lines get the same filtering as in line mode (but realtime commands are not accepted inside the frame)
+	switch(c)
+	{
+		case '(':
+			serial_frame.comment = true;
+			return;
+		case ')':
+			serial_frame.comment = false;
+			return;
+		case RT_CMD_REPORT:
+			return;
+	}
+	
+	if((c > 0x22) && (c < 0x7B) && !serial_frame.comment)
+	{
+		serial_rx_frame_putc(c);
+	}
+}
+
+static void serial_rx_frame_end()
+{
+	bool valid = !serial_frame.rejected;
+	
+	//the binary gcode frame length must match the payload
+	if(serial_frame.binary && (serial_frame.len < 3 || serial_rx_buffer[(serial_rx_write + 1) % RX_BUFFER_SIZE] != (serial_frame.len - 3) || serial_frame.len > (BINARY_GCODE_MAX_PAYLOAD + 3)))
+	{
+		valid = false;
+	}
+	
+	if(!valid)
+	{
+		//frame is discarded and must be resent
+		if(!serial_frame.nak_sent)
+		{
+			serial_frame.nak_sent = true;
+			serial_frame.nak_pending = true;
+		}
+		return;
+	}
+	
+	if(serial_frame.seq != serial_frame.expected)
+	{
+		if((uint8_t)(serial_frame.expected - serial_frame.seq) <= BINARY_GCODE_FRAME_WINDOW)
+		{
+			//repeated frame that was already accepted (the acknowledge is resent)
+			serial_frame.ack_pending = true;
+		}
+		else if(!serial_frame.nak_sent)
+		{
+			//a frame was lost
+			serial_frame.nak_sent = true;
+			serial_frame.nak_pending = true;
+		}
+		return;
+	}
+	
+	if(!serial_frame.binary)
+	{
+		serial_rx_frame_putc('\n');
+	}
+	
+	//commits the frame to the RX buffer
+	serial_rx_write = serial_frame.write;
+	serial_rx_end_cmd();
+	serial_frame.ack = serial_frame.expected++;
+	serial_frame.ack_pending = true;
+	serial_frame.nak_sent = false;
+}
+
+static void serial_rx_frame_isr(unsigned char c)
+{
+	switch(serial_frame.state)
+	{
+		case SERIAL_FRAME_SOH:
+			if(c == BINARY_GCODE_FRAME_SOH)
+			{
+				serial_frame.crc = 0xFFFF;
+				serial_frame.state = SERIAL_FRAME_SEQ;
+			}
+			else if((c < 0x23) || (c > 0x7A))
+			{
+				//outside of frames only realtime commands are accepted
+				cnc_call_rt_command((uint8_t)c);
+			}
+			else if(c == RT_CMD_REPORT)
+			{
+				cnc_call_rt_command((uint8_t)RT_CMD_REPORT);
+			}
+			return;
+		case SERIAL_FRAME_SEQ:
+			serial_frame.seq = c;
+			serial_frame.state = SERIAL_FRAME_LEN;
+			break;
+		case SERIAL_FRAME_LEN:
+			serial_frame.len = c;
+			serial_frame.pos = 0;
+			serial_frame.write = serial_rx_write;
+			serial_frame.binary = false;
+			serial_frame.comment = false;
+			//the payload (and line end) must fit in the RX buffer
+			serial_frame.rejected = (c > BINARY_GCODE_FRAME_MAX_PAYLOAD || serial_get_rx_freebytes() <= c);
+			serial_frame.state = (c) ? SERIAL_FRAME_PAYLOAD : SERIAL_FRAME_CRC_MSB;
+			break;
+		case SERIAL_FRAME_PAYLOAD:
+			serial_rx_frame_payload(c);
+			if(serial_frame.pos == serial_frame.len)
+			{
+				serial_frame.state = SERIAL_FRAME_CRC_MSB;
+			}
+			break;
+		case SERIAL_FRAME_CRC_MSB:
+			serial_frame.rejected |= ((serial_frame.crc >> 8) != c);
+			serial_frame.state = SERIAL_FRAME_CRC_LSB;
+			return;
+		case SERIAL_FRAME_CRC_LSB:
+			serial_frame.rejected |= ((serial_frame.crc & 0xFF) != c);
+			serial_frame.state = SERIAL_FRAME_SOH;
+			serial_rx_frame_end();
+			return;
+	}
+	
+	serial_frame.crc = serial_crc16(c, serial_frame.crc);
+}
+
+/*
+	Binary gcode frames are stored without any filtering except for the realtime commands
+	The frame bytes are 7 bit values and the ones with the value of an ASCII realtime command are escaped
+	Returns false if the frame was aborted and the byte must be read as the start of a new command
+*/
+static bool serial_rx_binary_isr(unsigned char c)
+{
+	if(BINARY_GCODE_IS_REALTIME(c))
+	{
+		cnc_call_rt_command((uint8_t)c);
+		return true;
+	}
+	
+	uint32_t now = mcu_millis();
+	if((now - serial_rx_frame_time) > BINARY_GCODE_TIMEOUT)
+	{
+		//the host stopped in the middle of the frame (answered with error:14)
+		serial_rx_frame = 0;
+		serial_rx_frame_escape = false;
+		serial_rx_overflow = true;
+		serial_rx_end_cmd();
+		return false;
+	}
+	
+	serial_rx_frame_time = now;
+	if(c == BINARY_GCODE_ESC)
+	{
+		serial_rx_frame_escape = true;
+		return true;
+	}
+	
+	if(serial_rx_frame_escape)
+	{
+		serial_rx_frame_escape = false;
+		c ^= BINARY_GCODE_ESC_XOR;
+	}
+	
+	if(serial_rx_frame == SERIAL_RX_FRAME_LENGTH) //length byte
+	{
+		serial_rx_frame = c + 2; //payload + CRC (+ this byte)
+		//oversized frames are skipped to the end and answered with error:14 (line length exceeded)
+		if(c > BINARY_GCODE_MAX_PAYLOAD)
+		{
+			serial_rx_overflow = true;
+		}
+	}
+	
+	serial_rx_frame--;
+	serial_rx_putc(c, !serial_rx_frame);
+	if(!serial_rx_frame)
+	{
+		serial_rx_end_cmd();
+	}
+	
+	return true;
+}
+
 void serial_rx_isr(unsigned char c)
 {
 	static uint8_t comment_count = 0;
 	
+	if(serial_frame.enabled)
+	{
+		serial_rx_frame_isr(c);
+		return;
+	}
+	
 	//c &= 0x7F;
 	
+	if(serial_rx_frame && serial_rx_binary_isr(c))
+	{
+		return;
+	}
+	
+	if(BINARY_GCODE_IS_FRAME(c) && !comment_count)
+	{
+		serial_rx_frame = SERIAL_RX_FRAME_LENGTH;
+		serial_rx_frame_time = mcu_millis();
+		serial_rx_putc(c, false);
+		return;
+	}
+	
 	if((c > 0x22) && (c < 0x7B))
 	{
 		switch(c)
@@ -329,8 +939,7 @@ void serial_rx_isr(unsigned char c)
 			default:
 				if(!comment_count)
 				{
-					serial_rx_buffer[serial_rx_write] = c;
-					serial_rx_write++;
+					serial_rx_putc(c, false);
 				}
 				break;
 		}
@@ -340,11 +949,10 @@ void serial_rx_isr(unsigned char c)
 		switch(c)
 		{
 			case '\r':
-				c = '\n';//replaces CR with LF
 			case '\n':
-				serial_rx_buffer[serial_rx_write] = c;
-				serial_rx_write++;
-				serial_rx_count++;
+				//replaces CR with LF
+				serial_rx_putc('\n', true);
+				serial_rx_end_cmd();
 				comment_count = 0;
 				break;
 			default:
@@ -352,26 +960,16 @@ void serial_rx_isr(unsigned char c)
 				return;
 		}
 	}
-	
-	if(serial_rx_write == RX_BUFFER_SIZE)
-	{
-		serial_rx_write = 0;
-	}
 }
 
 unsigned char serial_tx_isr()
 {
-	if(serial_tx_count == 0)
+	if(serial_tx_read == serial_tx_end)
 	{
 		return 0;
 	}
 	
 	unsigned char c = serial_tx_buffer[serial_tx_read];
-	
-	if(c == '\n')
-	{
-		serial_tx_count--;
-	}
 
 	if(++serial_tx_read == TX_BUFFER_SIZE)
 	{
@@ -26,21 +26,39 @@
 void serial_init();
 void serial_clear();
 
+//returned by serial_peek when the next command did not fit in the RX buffer and was discarded
+#define SERIAL_RX_OVERFLOW 0x7F
+
 bool serial_rx_is_empty();
+uint16_t serial_get_rx_freebytes();
 unsigned char serial_getc();
 unsigned char serial_peek();
+uint8_t serial_get_frame(uint8_t* buffer, uint8_t size);
 void serial_inject_cmd(const unsigned char* __s);
 void serial_discard_cmd();
 
 bool serial_tx_is_empty();
+bool serial_tx_reserve(uint8_t len);
 void serial_putc(unsigned char c);
 void serial_print_str(const unsigned char* __s);
-void serial_print_int(uint16_t num);
+void serial_print_int(int32_t num);
+void serial_print_fixed(int32_t num, uint8_t decimals);
 void serial_print_flt(float num);
 void serial_print_intarr(uint16_t* arr, uint8_t count);
 void serial_print_fltarr(float* arr, uint8_t count);
 void serial_flush();
 
+//framed streaming mode
+void serial_set_framed_mode(bool enable);
+bool serial_get_frame_ack(uint8_t* seq);
+bool serial_get_frame_nak(uint8_t* seq);
+
+//number formatters (write to buffer and return the number of chars written)
+//the buffer must hold at least SERIAL_FMT_BUFFER_SIZE chars
+#define SERIAL_FMT_BUFFER_SIZE 12
+uint8_t serial_fmt_fixed(unsigned char* buffer, int32_t num, uint8_t decimals);
+uint8_t serial_fmt_flt(unsigned char* buffer, float num);
+
 //ISR
 void serial_rx_isr(unsigned char c);
 unsigned char serial_tx_isr();
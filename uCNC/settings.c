@@ -17,6 +17,8 @@
 	See the	GNU General Public License for more details.
 */
 
+#include <stddef.h>
+#include <string.h>
 #include "config.h"
 #include "defaults.h"
 #include "settings.h"
@@ -24,12 +26,18 @@
 #include "mcu.h"
 #include "grbl_interface.h"
 #include "protocol.h"
-#include "parser.h"
 
-//if settings struct is changed this version has to change too
-#define SETTINGS_VERSION "V01"
+/*
+	The settings are stored as tagged records (setting id, value size and value) after the version of the schema.
+	Adding or removing a setting doesn't require a new version (records that are missing keep the default value
+	and records that are unknown are skipped). The version only has to change if the meaning or the encoding of an
+	existing setting changes and in that case a migration routine for the previous version must be added to settings_migrate.
+*/
+#define SETTINGS_VERSION "V04"
+#define SETTINGS_VERSION_SIZE 3
 
 settings_t g_settings;
+settings_derived_t g_settings_derived;
 
 #ifndef CRC_WITHOUT_LOOKUP_TABLE
 
@@ -67,9 +75,15 @@ const uint8_t __rom__ crc7_table[256] = {
 	0x0e, 0x07, 0x1c, 0x15, 0x2a, 0x23, 0x38, 0x31,
 	0x46, 0x4f, 0x54, 0x5d, 0x62, 0x6b, 0x70, 0x79
 };
-#else
-static uint8_t crc7(uint8_t c, uint8_t crc)
+#endif
+
+//updates the CRC7 with the next byte
+//also used to check the integrity of binary gcode frames
+uint8_t crc7(uint8_t c, uint8_t crc)
 {
+#ifndef CRC_WITHOUT_LOOKUP_TABLE
+	return rom_strptr(&crc7_table[crc ^ c]);
+#else
 	crc ^= (c & 0x80) ? (c ^ 0x89) : c;
 	for (uint8_t i = 7; i != 0; i--)
 	{
@@ -80,11 +94,10 @@ static uint8_t crc7(uint8_t c, uint8_t crc)
 		}
 	}
 	return(crc);
-}
 #endif
+}
 
 const settings_t __rom__ default_settings = {
-	.version = SETTINGS_VERSION,
 	#ifdef AXIS_X
 	.step_per_mm[AXIS_X] = DEFAULT_X_STEP_PER_MM,
 	.max_feed_rate[AXIS_X] = DEFAULT_X_MAX_FEED,
@@ -134,6 +147,7 @@ const settings_t __rom__ default_settings = {
 	.tool_count = DEFAULT_TOOL_COUNT,
 	.limits_invert_mask = DEFAULT_LIMIT_INV_MASK,
 	.status_report_mask = DEFAULT_STATUS_MASK,
+	.status_report_interval = DEFAULT_STATUS_REPORT_INTERVAL,
 	.control_invert_mask = DEFAULT_CONTROL_INV_MASK,
 	.max_step_rate = DEFAULT_MAX_STEP_RATE,
 	.report_inches = DEFAULT_REPORT_INCHES,
@@ -142,91 +156,533 @@ const settings_t __rom__ default_settings = {
 	.homing_enabled = DEFAULT_HOMING_ENABLED,
 	.spindle_max_rpm = DEFAULT_SPINDLE_MAX_RPM,
 	.spindle_min_rpm = DEFAULT_SPINDLE_MIN_RPM,
-	.crc = 0
+	#if(MACHINE_KINEMATICS == MACHINE_DELTA)
+	.delta_arm_length = DEFAULT_DELTA_ARM_LENGTH,
+	.delta_radius = DEFAULT_DELTA_RADIUS
+	#elif(MACHINE_KINEMATICS == MACHINE_SCARA)
+	.scara_arm_length = {DEFAULT_SCARA_UPPER_ARM_LENGTH, DEFAULT_SCARA_FOREARM_LENGTH},
+	.scara_home_angle = {DEFAULT_SCARA_SHOULDER_HOME_ANGLE, DEFAULT_SCARA_ELBOW_HOME_ANGLE},
+	#endif
+	#ifdef ENABLE_SKEW_COMPENSATION
+	.skew_factor = {DEFAULT_SKEW_XY, DEFAULT_SKEW_XZ, DEFAULT_SKEW_YZ},
+	.axis_scale = {DEFAULT_X_SCALE, DEFAULT_Y_SCALE, DEFAULT_Z_SCALE}
+	#endif
 	};
 
-//static uint8_t settings_crc;
+/*
+	Settings records
+	The id of each setting is the grbl setting number ($) and settings without a number use ids from 200 up
+*/
+typedef struct
+{
+	uint8_t id;
+	uint8_t offset;
+	uint8_t size;
+} settings_record_t;
 
+#define SETTINGS_RECORD(ID, FIELD) {ID, offsetof(settings_t, FIELD), sizeof(((settings_t*)0)->FIELD)}
+#define SETTINGS_AXIS_RECORDS(AXIS) \
+	SETTINGS_RECORD(100 + AXIS, step_per_mm[AXIS]), \
+	SETTINGS_RECORD(110 + AXIS, max_feed_rate[AXIS]), \
+	SETTINGS_RECORD(120 + AXIS, acceleration[AXIS]), \
+	SETTINGS_RECORD(130 + AXIS, max_distance[AXIS])
 
-void settings_init()
+const settings_record_t __rom__ settings_records[] = {
+	SETTINGS_RECORD(0, max_step_rate),
+	SETTINGS_RECORD(2, step_invert_mask),
+	SETTINGS_RECORD(3, dir_invert_mask),
+	SETTINGS_RECORD(4, step_enable_invert),
+	SETTINGS_RECORD(5, limits_invert_mask),
+	SETTINGS_RECORD(6, probe_invert_mask),
+	SETTINGS_RECORD(7, control_invert_mask),
+	SETTINGS_RECORD(10, status_report_mask),
+	SETTINGS_RECORD(12, arc_tolerance),
+	SETTINGS_RECORD(13, report_inches),
+	SETTINGS_RECORD(15, status_report_interval),
+	SETTINGS_RECORD(20, soft_limits_enabled),
+	SETTINGS_RECORD(21, hard_limits_enabled),
+	SETTINGS_RECORD(22, homing_enabled),
+	SETTINGS_RECORD(23, homing_dir_invert_mask),
+	SETTINGS_RECORD(24, homing_slow_feed_rate),
+	SETTINGS_RECORD(25, homing_fast_feed_rate),
+	SETTINGS_RECORD(27, homing_offset),
+	SETTINGS_RECORD(30, spindle_max_rpm),
+	SETTINGS_RECORD(31, spindle_min_rpm),
+	#if(MACHINE_KINEMATICS == MACHINE_DELTA)
+	SETTINGS_RECORD(28, delta_arm_length),
+	SETTINGS_RECORD(29, delta_radius),
+	#elif(MACHINE_KINEMATICS == MACHINE_SCARA)
+	SETTINGS_RECORD(28, scara_arm_length[0]),
+	SETTINGS_RECORD(29, scara_arm_length[1]),
+	SETTINGS_RECORD(36, scara_home_angle[0]),
+	SETTINGS_RECORD(37, scara_home_angle[1]),
+	#endif
+	#ifdef ENABLE_SKEW_COMPENSATION
+	SETTINGS_RECORD(40, skew_factor[0]),
+	SETTINGS_RECORD(41, skew_factor[1]),
+	SETTINGS_RECORD(42, skew_factor[2]),
+	SETTINGS_RECORD(140, axis_scale[0]),
+	SETTINGS_RECORD(141, axis_scale[1]),
+	SETTINGS_RECORD(142, axis_scale[2]),
+	#endif
+	#if(AXIS_COUNT > 0)
+	SETTINGS_AXIS_RECORDS(0),
+	#endif
+	#if(AXIS_COUNT > 1)
+	SETTINGS_AXIS_RECORDS(1),
+	#endif
+	#if(AXIS_COUNT > 2)
+	SETTINGS_AXIS_RECORDS(2),
+	#endif
+	#if(AXIS_COUNT > 3)
+	SETTINGS_AXIS_RECORDS(3),
+	#endif
+	#if(AXIS_COUNT > 4)
+	SETTINGS_AXIS_RECORDS(4),
+	#endif
+	#if(AXIS_COUNT > 5)
+	SETTINGS_AXIS_RECORDS(5),
+	#endif
+	SETTINGS_RECORD(200, tool_count)
+};
+
+#define SETTINGS_RECORD_COUNT (sizeof(settings_records) / sizeof(settings_record_t))
+
+/*
+	Layout of the V03 settings (the settings struct was stored as a single block followed by the CRC)
+	Only used to migrate the settings to the tagged records
+*/
+typedef struct
+{
+	char version[3];
+	uint16_t max_step_rate;
+	uint8_t step_invert_mask;
+	uint8_t dir_invert_mask;
+	bool step_enable_invert;
+	uint8_t limits_invert_mask;
+	bool probe_invert_mask;
+	uint8_t status_report_mask;
+	uint16_t status_report_interval;
+	uint8_t control_invert_mask;
+	float arc_tolerance;
+	bool report_inches;
+	bool soft_limits_enabled;
+	bool hard_limits_enabled;
+	bool homing_enabled;
+	uint8_t homing_dir_invert_mask;
+	float homing_fast_feed_rate;
+	float homing_slow_feed_rate;
+	float homing_offset;
+	float spindle_max_rpm;
+	float spindle_min_rpm;
+	float step_per_mm[AXIS_COUNT];
+	float max_feed_rate[AXIS_COUNT];
+	float acceleration[AXIS_COUNT];
+	float max_distance[AXIS_COUNT];
+	uint8_t tool_count;
+} settings_v03_t;
+
+/*
+	Writes to the non volatile memory are staged in a RAM page and written in a single block when
+	the next page is accessed or at the end of the save (the mcu only writes the bytes that changed)
+*/
+#define SETTINGS_PAGE_SIZE 16
+#define SETTINGS_PAGE_INVALID 0xFFFF
+
+static uint8_t settings_page[SETTINGS_PAGE_SIZE];
+static uint16_t settings_page_address;
+static bool settings_page_dirty;
+
+//slot and sequence number of the last parser parameters record
+static uint8_t settings_parameters_slot;
+static uint8_t settings_parameters_seq;
+
+static void settings_flush()
 {
-	uint8_t crc = settings_load(SETTINGS_ADDRESS_OFFSET, (uint8_t*) &g_settings, sizeof(settings_t) - 1);
-	if(crc != g_settings.crc || g_settings.crc == 0)
+	if(!settings_page_dirty)
 	{
-		settings_reset();
-		parser_parameters_reset();
-		protocol_send_error(STATUS_SETTING_READ_FAIL);
+		return;
 	}
+
+	//the mcu only writes the bytes that changed
+	mcu_eeprom_write(settings_page_address, settings_page, SETTINGS_PAGE_SIZE);
+	settings_page_dirty = false;
 }
 
-uint8_t settings_load(uint16_t address, uint8_t* __ptr, uint16_t size)
+static void settings_putc(uint16_t address, uint8_t value)
 {
-	uint8_t settings_crc = 0;
-	for(uint16_t i = size; i !=0; )
+	uint16_t page = address & ~(SETTINGS_PAGE_SIZE - 1);
+	if(page != settings_page_address)
 	{
-		i--;
-		__ptr[i] = mcu_eeprom_getc(i + address);
-		#ifndef CRC_WITHOUT_LOOKUP_TABLE
-		settings_crc ^= __ptr[i];
-		settings_crc = *(uint8_t*)rom_read_byte(&crc7_table[settings_crc]);
-		#else
-		settings_crc = crc7(__ptr[i], settings_crc);
-		#endif
+		settings_flush();
+		settings_page_address = page;
+		mcu_eeprom_read(page, settings_page, SETTINGS_PAGE_SIZE);
 	}
-	
-	if(address == SETTINGS_ADDRESS_OFFSET)
+
+	uint8_t offset = address & (SETTINGS_PAGE_SIZE - 1);
+	if(settings_page[offset] != value)
 	{
-		g_settings.crc = mcu_eeprom_getc(size + 1 + address);
+		settings_page[offset] = value;
+		settings_page_dirty = true;
 	}
-	
-	return settings_crc;
 }
 
-void settings_reset()
+static uint8_t settings_getc(uint16_t address)
 {
-	uint8_t* __ptr = (uint8_t*)&g_settings;
-	uint8_t size = sizeof(settings_t) - 1;
-	
-	rom_memcpy(&g_settings, &default_settings, size);
-	g_settings.crc = 0;
-	for(uint16_t i = size; i !=0; )
+	uint8_t c;
+	settings_flush();
+	mcu_eeprom_read(address, &c, 1);
+	return c;
+}
+
+//reads a block (if __ptr is NULL the block is only checked) and updates the CRC
+static uint8_t settings_read(uint16_t address, uint8_t* __ptr, uint16_t size, uint8_t crc)
+{
+	uint8_t buffer[SETTINGS_PAGE_SIZE];
+
+	//the staged page is written first so that the reads are up to date
+	settings_flush();
+	while(size != 0)
 	{
-		i--;
-		#ifndef CRC_WITHOUT_LOOKUP_TABLE
-		g_settings.crc = *(uint8_t*)rom_read_byte(&crc7_table[g_settings.crc ^ __ptr[i]]);
-		#else
-		g_settings.crc = crc7(__ptr[i], g_settings.crc);
-		#endif
+		uint16_t len = (__ptr != NULL) ? size : MIN(size, SETTINGS_PAGE_SIZE);
+		uint8_t* ptr = (__ptr != NULL) ? __ptr : buffer;
+		mcu_eeprom_read(address, ptr, len);
+		for(uint16_t i = 0; i < len; i++)
+		{
+			crc = crc7(ptr[i], crc);
+		}
+
+		address += len;
+		size -= len;
 	}
 
-	settings_save(SETTINGS_ADDRESS_OFFSET, (const uint8_t*)&g_settings, sizeof(settings_t));
+	return crc;
 }
 
-void settings_save(uint16_t address, const uint8_t* __ptr, uint16_t size)
+static uint8_t settings_write(uint16_t address, const uint8_t* __ptr, uint16_t size, uint8_t crc)
 {
-	uint8_t crc = 0;
-	for(uint16_t i = size; i !=0; )
+	for(uint16_t i = 0; i < size; i++)
 	{
-		i--;
-		mcu_eeprom_putc(i + address, __ptr[i]);
-		#ifndef CRC_WITHOUT_LOOKUP_TABLE
-		crc = *(uint8_t*)rom_read_byte(&crc7_table[crc ^ __ptr[i]]);
-		#else
+		settings_putc(address + i, __ptr[i]);
 		crc = crc7(__ptr[i], crc);
-		#endif
 	}
-	
-	mcu_eeprom_putc(size + address, crc);
+
+	return crc;
+}
+
+static void settings_update_derived()
+{
+	for(uint8_t i = 0; i < AXIS_COUNT; i++)
+	{
+		g_settings_derived.mm_per_step[i] = 1.0f / g_settings.step_per_mm[i];
+		g_settings_derived.max_feed_rate_inv[i] = 1.0f / (g_settings.max_feed_rate[i] * MIN_SEC_MULT);
+		g_settings_derived.acceleration_inv[i] = 1.0f / g_settings.acceleration[i];
+	}
+
+	g_settings_derived.spindle_pwm_scale = 255.0f / g_settings.spindle_max_rpm;
+
+	#if(MACHINE_KINEMATICS == MACHINE_DELTA)
+	//cos(30) = 0.8660254 and sin(30) = 0.5
+	g_settings_derived.delta_tower_x[0] = -0.8660254f * g_settings.delta_radius;
+	g_settings_derived.delta_tower_y[0] = -0.5f * g_settings.delta_radius;
+	g_settings_derived.delta_tower_x[1] = 0.8660254f * g_settings.delta_radius;
+	g_settings_derived.delta_tower_y[1] = -0.5f * g_settings.delta_radius;
+	g_settings_derived.delta_tower_x[2] = 0;
+	g_settings_derived.delta_tower_y[2] = g_settings.delta_radius;
+	g_settings_derived.delta_arm_sqr = g_settings.delta_arm_length * g_settings.delta_arm_length;
+	#elif(MACHINE_KINEMATICS == MACHINE_SCARA)
+	g_settings_derived.scara_arm_sqr_sum = g_settings.scara_arm_length[0] * g_settings.scara_arm_length[0] + g_settings.scara_arm_length[1] * g_settings.scara_arm_length[1];
+	g_settings_derived.scara_cos_scale = 0.5f / (g_settings.scara_arm_length[0] * g_settings.scara_arm_length[1]);
+	#endif
+
+	#ifdef ENABLE_SKEW_COMPENSATION
+	/*
+		the measured error matrix is
+		| sx kxy kxz |
+		| 0  sy  kyz |
+		| 0  0   sz  |
+		and the correction is its inverse (also upper triangular)
+	*/
+	float sx_inv = 1.0f / g_settings.axis_scale[0];
+	float sy_inv = 1.0f / g_settings.axis_scale[1];
+	float sz_inv = 1.0f / g_settings.axis_scale[2];
+	float kxy = g_settings.skew_factor[0];
+	float kxz = g_settings.skew_factor[1];
+	float kyz = g_settings.skew_factor[2];
+	memset(g_settings_derived.skew_correction, 0, sizeof(g_settings_derived.skew_correction));
+	g_settings_derived.skew_correction[0][0] = sx_inv;
+	g_settings_derived.skew_correction[0][1] = -kxy * sx_inv * sy_inv;
+	g_settings_derived.skew_correction[0][2] = (kxy * kyz * sy_inv - kxz) * sx_inv * sz_inv;
+	g_settings_derived.skew_correction[1][1] = sy_inv;
+	g_settings_derived.skew_correction[1][2] = -kyz * sy_inv * sz_inv;
+	g_settings_derived.skew_correction[2][2] = sz_inv;
+	#endif
+}
+
+//finds the setting record with the given id
+static int8_t settings_find_record(uint8_t id)
+{
+	for(uint8_t i = 0; i < SETTINGS_RECORD_COUNT; i++)
+	{
+		if(rom_strptr(&settings_records[i].id) == id)
+		{
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+/*
+	Loads the records of the current version over the default settings
+	Returns the number of records loaded or -1 if the records are corrupted
+*/
+static int16_t settings_load_records()
+{
+	uint16_t address = SETTINGS_ADDRESS_OFFSET + SETTINGS_VERSION_SIZE;
+	uint8_t count = settings_getc(address);
+	uint8_t crc = settings_read(SETTINGS_ADDRESS_OFFSET, NULL, SETTINGS_VERSION_SIZE + 1, 0);
+	int16_t loaded = 0;
+	address++;
+
+	rom_memcpy(&g_settings, &default_settings, sizeof(settings_t));
+	for(uint8_t i = 0; i < count; i++)
+	{
+		uint8_t id = settings_getc(address);
+		uint8_t size = settings_getc(address + 1);
+		crc = settings_read(address, NULL, 2, crc);
+		address += 2;
+		if(address + size >= SETTINGS_HEIGHTMAP_ADDRESS_OFFSET)
+		{
+			return -1;
+		}
+
+		//only the records of the known settings are loaded (others are skipped)
+		int8_t record = settings_find_record(id);
+		if(record >= 0 && size == rom_strptr(&settings_records[record].size))
+		{
+			crc = settings_read(address, ((uint8_t*)&g_settings) + rom_strptr(&settings_records[record].offset), size, crc);
+			loaded++;
+		}
+		else
+		{
+			crc = settings_read(address, NULL, size, crc);
+		}
+
+		address += size;
+	}
+
+	return (crc == settings_getc(address)) ? loaded : -1;
+}
+
+static void settings_save_records()
+{
+	uint16_t address = SETTINGS_ADDRESS_OFFSET;
+	uint8_t count = SETTINGS_RECORD_COUNT;
+
+	uint8_t crc = settings_write(address, (const uint8_t*)SETTINGS_VERSION, SETTINGS_VERSION_SIZE, 0);
+	address += SETTINGS_VERSION_SIZE;
+	crc = settings_write(address++, &count, 1, crc);
+	for(uint8_t i = 0; i < SETTINGS_RECORD_COUNT; i++)
+	{
+		uint8_t header[2];
+		header[0] = rom_strptr(&settings_records[i].id);
+		header[1] = rom_strptr(&settings_records[i].size);
+		crc = settings_write(address, header, 2, crc);
+		address += 2;
+		crc = settings_write(address, ((const uint8_t*)&g_settings) + rom_strptr(&settings_records[i].offset), header[1], crc);
+		address += header[1];
+	}
+
+	settings_putc(address, crc);
+	settings_flush();
+}
+
+//V03 to V04 (single block to tagged records)
+static bool settings_migrate_v03()
+{
+	settings_v03_t old;
+	if(!settings_load(SETTINGS_ADDRESS_OFFSET, (uint8_t*)&old, sizeof(settings_v03_t)))
+	{
+		return false;
+	}
+
+	rom_memcpy(&g_settings, &default_settings, sizeof(settings_t));
+	g_settings.max_step_rate = old.max_step_rate;
+	g_settings.step_invert_mask = old.step_invert_mask;
+	g_settings.dir_invert_mask = old.dir_invert_mask;
+	g_settings.step_enable_invert = old.step_enable_invert;
+	g_settings.limits_invert_mask = old.limits_invert_mask;
+	g_settings.probe_invert_mask = old.probe_invert_mask;
+	g_settings.status_report_mask = old.status_report_mask;
+	g_settings.status_report_interval = old.status_report_interval;
+	g_settings.control_invert_mask = old.control_invert_mask;
+	g_settings.arc_tolerance = old.arc_tolerance;
+	g_settings.report_inches = old.report_inches;
+	g_settings.soft_limits_enabled = old.soft_limits_enabled;
+	g_settings.hard_limits_enabled = old.hard_limits_enabled;
+	g_settings.homing_enabled = old.homing_enabled;
+	g_settings.homing_dir_invert_mask = old.homing_dir_invert_mask;
+	g_settings.homing_fast_feed_rate = old.homing_fast_feed_rate;
+	g_settings.homing_slow_feed_rate = old.homing_slow_feed_rate;
+	g_settings.homing_offset = old.homing_offset;
+	g_settings.spindle_max_rpm = old.spindle_max_rpm;
+	g_settings.spindle_min_rpm = old.spindle_min_rpm;
+	memcpy(g_settings.step_per_mm, old.step_per_mm, sizeof(g_settings.step_per_mm));
+	memcpy(g_settings.max_feed_rate, old.max_feed_rate, sizeof(g_settings.max_feed_rate));
+	memcpy(g_settings.acceleration, old.acceleration, sizeof(g_settings.acceleration));
+	memcpy(g_settings.max_distance, old.max_distance, sizeof(g_settings.max_distance));
+	g_settings.tool_count = old.tool_count;
+	return true;
+}
+
+/*
+	Runs the migration routine of the stored version (must leave the settings loaded in g_settings)
+	New versions add their predecessor here
+*/
+static bool settings_migrate(const char* version)
+{
+	if(!memcmp(version, "V03", SETTINGS_VERSION_SIZE))
+	{
+		return settings_migrate_v03();
+	}
+
+	return false;
+}
+
+void settings_init()
+{
+	char version[SETTINGS_VERSION_SIZE];
+	settings_page_address = SETTINGS_PAGE_INVALID;
+	settings_page_dirty = false;
+
+	settings_read(SETTINGS_ADDRESS_OFFSET, (uint8_t*)version, SETTINGS_VERSION_SIZE, 0);
+	if(!memcmp(version, SETTINGS_VERSION, SETTINGS_VERSION_SIZE))
+	{
+		int16_t loaded = settings_load_records();
+		if(loaded < 0)
+		{
+			settings_reset();
+			protocol_send_error(STATUS_SETTING_READ_FAIL);
+		}
+		else if(loaded != SETTINGS_RECORD_COUNT)
+		{
+			//adds the records of new settings (and drops the unknown ones)
+			settings_save_records();
+		}
+	}
+	else if(settings_migrate(version))
+	{
+		settings_save_records();
+	}
+	else
+	{
+		settings_reset();
+		protocol_send_error(STATUS_SETTING_READ_FAIL);
+	}
+
+	settings_update_derived();
+}
+
+bool settings_load(uint16_t address, uint8_t* __ptr, uint16_t size)
+{
+	uint8_t crc = settings_read(address, __ptr, size, 0);
+	return (crc == settings_getc(address + size));
+}
+
+void settings_reset()
+{
+	rom_memcpy(&g_settings, &default_settings, sizeof(settings_t));
+	settings_update_derived();
+	settings_save_records();
+}
+
+void settings_save(uint16_t address, const uint8_t* __ptr, uint16_t size)
+{
+	uint8_t crc = settings_write(address, __ptr, size, 0);
+	settings_putc(address + size, crc);
+	settings_flush();
+}
+
+/*
+	The parser parameters (G10, G92.1, etc...) are saved in records that rotate through all the slots
+	that fit after SETTINGS_PARSER_PARAMETERS_ADDRESS_OFFSET to spread the wear of the non volatile memory.
+	Each record holds a sequence number, the parameters and the CRC of both.
+	The valid record with the most recent sequence number is loaded.
+*/
+static uint8_t settings_parameters_slots(uint16_t size)
+{
+	return (uint8_t)((EEPROM_SIZE - SETTINGS_PARSER_PARAMETERS_ADDRESS_OFFSET) / (size + 2));
+}
+
+bool settings_load_parameters(uint8_t* __ptr, uint16_t size)
+{
+	uint8_t slots = settings_parameters_slots(size);
+	bool found = false;
+
+	for(uint8_t slot = 0; slot < slots; slot++)
+	{
+		uint16_t address = SETTINGS_PARSER_PARAMETERS_ADDRESS_OFFSET + slot * (size + 2);
+		uint8_t seq = settings_getc(address);
+		uint8_t crc = settings_read(address, NULL, size + 1, 0);
+		if(crc != settings_getc(address + size + 1))
+		{
+			continue;
+		}
+
+		//the sequence numbers wrap around
+		if(!found || (int8_t)(seq - settings_parameters_seq) > 0)
+		{
+			found = true;
+			settings_parameters_slot = slot;
+			settings_parameters_seq = seq;
+		}
+	}
+
+	if(!found)
+	{
+		//the next record is saved in the first slot
+		settings_parameters_slot = slots - 1;
+		settings_parameters_seq = 0xFF;
+		memset(__ptr, 0, size);
+		return false;
+	}
+
+	settings_read(SETTINGS_PARSER_PARAMETERS_ADDRESS_OFFSET + settings_parameters_slot * (size + 2) + 1, __ptr, size, 0);
+	return true;
+}
+
+void settings_save_parameters(const uint8_t* __ptr, uint16_t size)
+{
+	if(++settings_parameters_slot >= settings_parameters_slots(size))
+	{
+		settings_parameters_slot = 0;
+	}
+
+	settings_parameters_seq++;
+	uint16_t address = SETTINGS_PARSER_PARAMETERS_ADDRESS_OFFSET + settings_parameters_slot * (size + 2);
+	uint8_t crc = settings_write(address, &settings_parameters_seq, 1, 0);
+	crc = settings_write(address + 1, __ptr, size, crc);
+	settings_putc(address + size + 1, crc);
+	settings_flush();
 }
 
 uint8_t settings_change(uint8_t setting, float value)
 {
 	uint8_t result = 0;
 	uint8_t value8 = (uint8_t)value;
-	uint8_t value16 = (uint16_t)value;
+	uint16_t value16 = (uint16_t)value;
 	bool value1 = (value!=0);
+	//only the skew factors and the SCARA home angles can be negative
+	bool signed_value = false;
+	#ifdef ENABLE_SKEW_COMPENSATION
+	signed_value = (setting >= 40 && setting <= 42);
+	#endif
+	#if(MACHINE_KINEMATICS == MACHINE_SCARA)
+	signed_value = (setting == 36 || setting == 37);
+	#endif
 
-	if(value < 0)
+	if(value < 0 && !signed_value)
 	{
 		return STATUS_NEGATIVE_VALUE;
 	}
@@ -267,6 +723,9 @@ uint8_t settings_change(uint8_t setting, float value)
 		case 13:
 			g_settings.report_inches = value;
 			break;
+		case 15:
+			g_settings.status_report_interval = value16;
+			break;
 		case 20:
 			if(!g_settings.homing_enabled)
 			{
@@ -292,12 +751,51 @@ uint8_t settings_change(uint8_t setting, float value)
 		case 27:
 			g_settings.homing_offset = value;
 			break;
+		#if(MACHINE_KINEMATICS == MACHINE_DELTA)
+		case 28:
+			g_settings.delta_arm_length = value;
+			break;
+		case 29:
+			g_settings.delta_radius = value;
+			break;
+		#elif(MACHINE_KINEMATICS == MACHINE_SCARA)
+		case 28:
+			g_settings.scara_arm_length[0] = value;
+			break;
+		case 29:
+			g_settings.scara_arm_length[1] = value;
+			break;
+		#endif
 		case 30:
 			g_settings.spindle_max_rpm = value;
 			break;
 		case 31:
 			g_settings.spindle_min_rpm = value;
 			break;
+		#if(MACHINE_KINEMATICS == MACHINE_SCARA)
+		case 36:
+			g_settings.scara_home_angle[0] = value;
+			break;
+		case 37:
+			g_settings.scara_home_angle[1] = value;
+			break;
+		#endif
+		#ifdef ENABLE_SKEW_COMPENSATION
+		case 40:
+		case 41:
+		case 42:
+			g_settings.skew_factor[setting - 40] = value;
+			break;
+		case 140:
+		case 141:
+		case 142:
+			if(value == 0)
+			{
+				return STATUS_INVALID_STATEMENT;
+			}
+			g_settings.axis_scale[setting - 140] = value;
+			break;
+		#endif
 		#if(AXIS_COUNT > 0)
 		case 100:
 			g_settings.step_per_mm[0] = value;
@@ -386,6 +884,7 @@ uint8_t settings_change(uint8_t setting, float value)
 			return STATUS_INVALID_STATEMENT;
 	}
 	
-	settings_save(SETTINGS_ADDRESS_OFFSET, (uint8_t*)&g_settings, sizeof(settings_t));
+	settings_update_derived();
+	settings_save_records();
 	return result;
 }
@@ -26,11 +26,12 @@
 #include "machinedefs.h"
 
 #define SETTINGS_ADDRESS_OFFSET 0
+#define SETTINGS_HEIGHTMAP_ADDRESS_OFFSET 384
 #define SETTINGS_PARSER_PARAMETERS_ADDRESS_OFFSET 512
 
+//new settings also need a record in settings_records (settings.c)
 typedef struct
 {
-	char version[3];
 	uint16_t max_step_rate;
 	//step delay not used
 	uint8_t step_invert_mask;
@@ -39,6 +40,7 @@ typedef struct
     uint8_t limits_invert_mask;
 	bool probe_invert_mask;
     uint8_t status_report_mask;
+    uint16_t status_report_interval;
     uint8_t control_invert_mask;
 	//juntion deviation is automatic and always on
 	float arc_tolerance;
@@ -53,6 +55,18 @@ typedef struct
 	float homing_offset;
 	float spindle_max_rpm;
 	float spindle_min_rpm;
+	#if(MACHINE_KINEMATICS == MACHINE_DELTA)
+	float delta_arm_length;
+	float delta_radius;
+	#elif(MACHINE_KINEMATICS == MACHINE_SCARA)
+	float scara_arm_length[2];
+	float scara_home_angle[2];
+	#endif
+	#ifdef ENABLE_SKEW_COMPENSATION
+	//measured XY, XZ and YZ skew and X, Y and Z scale
+	float skew_factor[3];
+	float axis_scale[3];
+	#endif
 	
 	float step_per_mm[AXIS_COUNT];
 	float max_feed_rate[AXIS_COUNT];
@@ -60,15 +74,49 @@ typedef struct
 	float max_distance[AXIS_COUNT];
 	
 	uint8_t tool_count;
-	uint8_t crc;
 } settings_t;
 
+/*
+	Values derived from the settings used in the motion hot paths (avoids divisions)
+	Rebuilt every time the settings are loaded or changed
+*/
+typedef struct
+{
+	float mm_per_step[AXIS_COUNT];
+	//inverse of the max feed rate in s/mm
+	float max_feed_rate_inv[AXIS_COUNT];
+	//inverse of the acceleration in s^2/mm
+	float acceleration_inv[AXIS_COUNT];
+	//converts the spindle speed to the PWM value (255 / spindle_max_rpm)
+	float spindle_pwm_scale;
+	#if(MACHINE_KINEMATICS == MACHINE_DELTA)
+	//tower positions in the XY plane (towers at 210, 330 and 90 degrees) and the squared arm length
+	float delta_tower_x[STEPPER_COUNT];
+	float delta_tower_y[STEPPER_COUNT];
+	float delta_arm_sqr;
+	#elif(MACHINE_KINEMATICS == MACHINE_SCARA)
+	//sum of the squared arm lengths and 1 / (2 * upper arm * forearm) (law of cosines of the elbow)
+	float scara_arm_sqr_sum;
+	float scara_cos_scale;
+	#endif
+	#ifdef ENABLE_SKEW_COMPENSATION
+	//inverse of the measured error matrix (upper triangular) that converts the positions to the motors positions
+	float skew_correction[3][3];
+	#endif
+} settings_derived_t;
+
 extern settings_t g_settings;
+extern settings_derived_t g_settings_derived;
 
 void settings_init();
-uint8_t settings_load(uint16_t address, uint8_t* __ptr, uint16_t size);
+//blocks are stored with a CRC (load returns false if the CRC check fails)
+bool settings_load(uint16_t address, uint8_t* __ptr, uint16_t size);
 void settings_save(uint16_t address, const uint8_t* __ptr, uint16_t size);
+//parser parameters with wear leveling
+bool settings_load_parameters(uint8_t* __ptr, uint16_t size);
+void settings_save_parameters(const uint8_t* __ptr, uint16_t size);
 void settings_reset();
 uint8_t settings_change(uint8_t setting, float value);
+uint8_t crc7(uint8_t c, uint8_t crc);
 
 #endif
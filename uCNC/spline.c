@@ -0,0 +1,177 @@
+/*
+	Name: spline.c
+	Description: Bezier spline motions (G5 and G5.1) for uCNC.
+		The curves are flattened into linear motions with an adaptive step.
+		The step is halved until the chord error is within the arc tolerance and doubled again
+		when the curve is flat enough, so straight sections use few segments and tight bends many.
+
+	Copyright: Copyright (c) João Martins
+	Author: João Martins
+	Date: 19/10/2026
+
+	uCNC is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version. Please see <http://www.gnu.org/licenses/>
+
+	uCNC is distributed WITHOUT ANY WARRANTY;
+	Also without the implied warranty of	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+	See the	GNU General Public License for more details.
+*/
+
+#include <math.h>
+#include <string.h>
+#include "config.h"
+#include "grbl_interface.h"
+#include "settings.h"
+#include "machinedefs.h"
+#include "planner.h"
+#include "motion_control.h"
+#include "spline.h"
+
+//limits of the curve parameter (t) increment of each segment
+#define SPLINE_MIN_STEP 0.001f
+#define SPLINE_MAX_STEP 0.25f
+#define SPLINE_INITIAL_STEP 0.0625f
+
+//cubic polynomial in the power basis B(t) = ((a * t + b) * t + c) * t + d
+typedef struct
+{
+	float a[2];
+	float b[2];
+	float c[2];
+	float d[2];
+} spline_poly_t;
+
+static inline void spline_eval(spline_poly_t *poly, float t, float *pt)
+{
+	pt[0] = ((poly->a[0] * t + poly->b[0]) * t + poly->c[0]) * t + poly->d[0];
+	pt[1] = ((poly->a[1] * t + poly->b[1]) * t + poly->c[1]) * t + poly->d[1];
+}
+
+static inline float spline_dist(float *pt0, float *pt1)
+{
+	float x = pt1[0] - pt0[0];
+	float y = pt1[1] - pt0[1];
+	return sqrtf(x * x + y * y);
+}
+
+uint8_t spline_cubic(float *target, float *ctrl_pt0, float *ctrl_pt1, uint8_t axis_0, uint8_t axis_1, planner_block_data_t block_data)
+{
+	float start[AXIS_COUNT];
+	float mc_position[AXIS_COUNT];
+	float increment[AXIS_COUNT];
+	float end_pt[2];
+	float last_pt[2];
+	spline_poly_t poly;
+
+	mc_get_position(start);
+	memcpy(mc_position, start, sizeof(mc_position));
+
+	last_pt[0] = start[axis_0];
+	last_pt[1] = start[axis_1];
+	end_pt[0] = target[axis_0];
+	end_pt[1] = target[axis_1];
+
+	//converts the bezier control points to the power basis
+	for (uint8_t i = 0; i < 2; i++)
+	{
+		poly.d[i] = last_pt[i];
+		poly.c[i] = 3 * (ctrl_pt0[i] - last_pt[i]);
+		poly.b[i] = 3 * (ctrl_pt1[i] - 2 * ctrl_pt0[i] + last_pt[i]);
+		poly.a[i] = end_pt[i] - last_pt[i] - poly.c[i] - poly.b[i];
+	}
+
+	//all other axis move linearly with the curve parameter
+	for (uint8_t i = AXIS_COUNT; i != 0;)
+	{
+		i--;
+		increment[i] = target[i] - start[i];
+	}
+
+	if (block_data.motion_mode == PLANNER_MOTION_MODE_INVERSEFEED)
+	{
+		//the curve length is aproximated by the average of the control polygon and chord lengths
+		//and the motion is executed at the constant feed that completes it in the required time
+		float length = 0.5f * (spline_dist(last_pt, ctrl_pt0) + spline_dist(ctrl_pt0, ctrl_pt1) + spline_dist(ctrl_pt1, end_pt) + spline_dist(last_pt, end_pt));
+		block_data.feed = length / block_data.feed;
+		block_data.motion_mode = PLANNER_MOTION_MODE_FEED;
+	}
+
+	float tolerance_sqr = g_settings.arc_tolerance * g_settings.arc_tolerance;
+	float t = 0;
+	float step = SPLINE_INITIAL_STEP;
+
+	for (;;)
+	{
+		float new_t = t + step;
+		if (new_t >= 1)
+		{
+			new_t = 1;
+			step = 1 - t;
+		}
+
+		float pt[2];
+		float mid_pt[2];
+		spline_eval(&poly, new_t, pt);
+		spline_eval(&poly, t + 0.5f * step, mid_pt);
+
+		//the distance from the curve middle point to the chord middle point estimates the chord error
+		float x = mid_pt[0] - 0.5f * (last_pt[0] + pt[0]);
+		float y = mid_pt[1] - 0.5f * (last_pt[1] + pt[1]);
+		float error_sqr = x * x + y * y;
+
+		if (error_sqr > tolerance_sqr && step > SPLINE_MIN_STEP)
+		{
+			step *= 0.5f;
+			continue;
+		}
+
+		// Ensure last segment arrives at target location.
+		if (new_t == 1)
+		{
+			return mc_line(target, block_data);
+		}
+
+		t = new_t;
+		last_pt[0] = pt[0];
+		last_pt[1] = pt[1];
+		for (uint8_t i = AXIS_COUNT; i != 0;)
+		{
+			i--;
+			mc_position[i] = start[i] + increment[i] * t;
+		}
+		mc_position[axis_0] = pt[0];
+		mc_position[axis_1] = pt[1];
+
+		uint8_t error = mc_line(mc_position, block_data);
+		if (error)
+		{
+			return error;
+		}
+
+		//the chord error grows with the square of the step
+		//if doubling the step still keeps it within tolerance the step is doubled
+		if ((16 * error_sqr) < tolerance_sqr && step < SPLINE_MAX_STEP)
+		{
+			step *= 2;
+		}
+	}
+}
+
+uint8_t spline_quadratic(float *target, float *ctrl_pt, uint8_t axis_0, uint8_t axis_1, planner_block_data_t block_data)
+{
+	float start[AXIS_COUNT];
+	float ctrl_pt0[2];
+	float ctrl_pt1[2];
+
+	mc_get_position(start);
+
+	//degree elevation of the quadratic bezier to a cubic bezier
+	ctrl_pt0[0] = start[axis_0] + 0.6666666667f * (ctrl_pt[0] - start[axis_0]);
+	ctrl_pt0[1] = start[axis_1] + 0.6666666667f * (ctrl_pt[1] - start[axis_1]);
+	ctrl_pt1[0] = target[axis_0] + 0.6666666667f * (ctrl_pt[0] - target[axis_0]);
+	ctrl_pt1[1] = target[axis_1] + 0.6666666667f * (ctrl_pt[1] - target[axis_1]);
+
+	return spline_cubic(target, ctrl_pt0, ctrl_pt1, axis_0, axis_1, block_data);
+}
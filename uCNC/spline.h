@@ -0,0 +1,38 @@
+/*
+	Name: spline.h
+	Description: Bezier spline motions (G5 and G5.1) for uCNC.
+		The curves are flattened into linear motions with a chord error within the arc tolerance.
+
+	Copyright: Copyright (c) João Martins
+	Author: João Martins
+	Date: 19/10/2026
+
+	uCNC is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version. Please see <http://www.gnu.org/licenses/>
+
+	uCNC is distributed WITHOUT ANY WARRANTY;
+	Also without the implied warranty of	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+	See the	GNU General Public License for more details.
+*/
+
+#ifndef SPLINE_H
+#define SPLINE_H
+
+#include <stdint.h>
+#include "planner.h"
+
+/*
+	Cubic bezier from the current position to target (G5)
+	ctrl_pt0 and ctrl_pt1 are the control points in machine absolute coordinates of the plane axis (axis_0 and axis_1)
+*/
+uint8_t spline_cubic(float *target, float *ctrl_pt0, float *ctrl_pt1, uint8_t axis_0, uint8_t axis_1, planner_block_data_t block_data);
+
+/*
+	Quadratic bezier from the current position to target (G5.1)
+	ctrl_pt is the control point in machine absolute coordinates of the plane axis (axis_0 and axis_1)
+*/
+uint8_t spline_quadratic(float *target, float *ctrl_pt, uint8_t axis_0, uint8_t axis_1, planner_block_data_t block_data);
+
+#endif
@@ -0,0 +1,282 @@
+/*
+	Name: storage.c
+	Description: Program storage for uCNC.
+		The stored program is read in blocks of STORAGE_BLOCK_SIZE bytes to a double buffer.
+		The parser consumes one of the blocks while the main loop prefetches the next one to the other,
+		so the parser only waits on the storage device if it consumes a whole block before the next one is loaded.
+		Each block is filtered when loaded with the same rules the serial RX ISR applies to the streamed commands
+		(white spaces and comments are removed and CR is replaced by LF). Binary gcode frames are also supported.
+
+	Copyright: Copyright (c) João Martins
+	Author: João Martins
+	Date: 19/10/2026
+
+	uCNC is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version. Please see <http://www.gnu.org/licenses/>
+
+	uCNC is distributed WITHOUT ANY WARRANTY;
+	Also without the implied warranty of	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+	See the	GNU General Public License for more details.
+*/
+
+#include "config.h"
+#include "grbl_interface.h"
+#include "mcudefs.h"
+#include "mcu.h"
+#include "utils.h"
+#include "binary_gcode.h"
+#include "cnc.h"
+#include "storage.h"
+
+#ifdef ENABLE_PROGRAM_STORAGE
+
+#define STORAGE_BUFFERS 2
+
+typedef struct
+{
+	bool running;
+	//size of the stored program and offset of the next block to load
+	uint32_t size;
+	uint32_t offset;
+	//double buffer (a block with length 0 is free)
+	uint8_t buffer[STORAGE_BUFFERS][STORAGE_BLOCK_SIZE];
+	uint16_t length[STORAGE_BUFFERS];
+	uint8_t current;
+	uint16_t read;
+	//filter state carried between blocks
+	uint8_t comment_count;
+	uint8_t frame;
+	bool escape;
+	//signals the last char read was not the end of a line
+	bool partial;
+} storage_t;
+
+static storage_t storage;
+
+//applies the serial RX filter to the block and returns the number of chars kept
+static uint16_t storage_filter(uint8_t* buffer, uint16_t len)
+{
+	uint16_t count = 0;
+	for(uint16_t i = 0; i < len; i++)
+	{
+		uint8_t c = buffer[i];
+
+		//binary gcode frames are stored without any filtering (only the escaped bytes are restored)
+		if(storage.frame)
+		{
+			//realtime commands have no meaning inside a stored program
+			if(BINARY_GCODE_IS_REALTIME(c))
+			{
+				continue;
+			}
+
+			if(c == BINARY_GCODE_ESC)
+			{
+				storage.escape = true;
+				continue;
+			}
+
+			if(storage.escape)
+			{
+				storage.escape = false;
+				c ^= BINARY_GCODE_ESC_XOR;
+			}
+
+			if(storage.frame == 0xFF) //length byte
+			{
+				//oversized frames are truncated and will fail the CRC check
+				c = MIN(c, BINARY_GCODE_MAX_PAYLOAD);
+				storage.frame = c + 2; //payload + CRC (+ this byte)
+			}
+
+			buffer[count++] = c;
+			storage.frame--;
+			continue;
+		}
+
+		if(BINARY_GCODE_IS_FRAME(c) && !storage.comment_count)
+		{
+			storage.frame = 0xFF;
+			buffer[count++] = c;
+			continue;
+		}
+
+		if((c > 0x22) && (c < 0x7B))
+		{
+			switch(c)
+			{
+				case RT_CMD_REPORT:
+					//realtime commands have no meaning inside a stored program
+					break;
+				case '(':
+					storage.comment_count++;
+					break;
+				case ')':
+					storage.comment_count--;
+					break;
+				default:
+					if(!storage.comment_count)
+					{
+						buffer[count++] = c;
+					}
+					break;
+			}
+		}
+		else if(c == '\r' || c == '\n')
+		{
+			buffer[count++] = '\n';
+			storage.comment_count = 0;
+		}
+	}
+
+	return count;
+}
+
+static void storage_load(uint8_t index)
+{
+	uint16_t len = 0;
+
+	//blocks that are completely filtered out (comments only) are skipped
+	while(!len && storage.offset < storage.size)
+	{
+		uint16_t read = mcu_storage_read(storage.offset, storage.buffer[index], STORAGE_BLOCK_SIZE);
+		if(!read)
+		{
+			//read failure ends the program
+			storage.offset = storage.size;
+			break;
+		}
+
+		storage.offset += read;
+		len = storage_filter(storage.buffer[index], read);
+	}
+
+	storage.length[index] = len;
+}
+
+//checks if there are chars to read (switches to the next block if the current one was consumed)
+static bool storage_available()
+{
+	if(storage.read == storage.length[storage.current])
+	{
+		storage.length[storage.current] = 0;
+		storage.read = 0;
+		storage.current ^= 1;
+		//if the next block was not prefetched yet it's loaded now
+		if(!storage.length[storage.current])
+		{
+			storage_load(storage.current);
+		}
+	}
+
+	return (storage.read < storage.length[storage.current]);
+}
+
+bool storage_open()
+{
+	memset(&storage, 0, sizeof(storage_t));
+	storage.size = mcu_storage_open();
+	if(!storage.size)
+	{
+		return false;
+	}
+
+	storage_load(0);
+	storage_load(1);
+	storage.running = true;
+	return true;
+}
+
+void storage_close()
+{
+	storage.running = false;
+}
+
+bool storage_is_running()
+{
+	return storage.running;
+}
+
+void storage_prefetch()
+{
+	if(!storage.running)
+	{
+		return;
+	}
+
+	uint8_t next = storage.current ^ 1;
+	if(!storage.length[next])
+	{
+		storage_load(next);
+	}
+
+	//the program ends after the last line is read and the commands return to the serial RX buffer
+	if(storage_is_empty())
+	{
+		storage.running = false;
+	}
+}
+
+bool storage_is_empty()
+{
+	return (!storage.partial && !storage_available());
+}
+
+unsigned char storage_getc()
+{
+	if(!storage_available())
+	{
+		//terminates the last line if the program does not end with a line end
+		if(storage.partial)
+		{
+			storage.partial = false;
+			return '\n';
+		}
+
+		return 0;
+	}
+
+	unsigned char c = storage.buffer[storage.current][storage.read++];
+	storage.partial = (c != '\n');
+	return c;
+}
+
+unsigned char storage_peek()
+{
+	if(!storage_available())
+	{
+		return (storage.partial ? '\n' : 0);
+	}
+
+	return storage.buffer[storage.current][storage.read];
+}
+
+uint8_t storage_get_frame(uint8_t* buffer, uint8_t size)
+{
+	//discards the opcode (already read by the parser)
+	storage_getc();
+	uint8_t len = storage_getc();
+
+	//copies the payload and the CRC
+	for(uint8_t i = 0; i <= len; i++)
+	{
+		uint8_t c = storage_getc();
+		if(i < size)
+		{
+			buffer[i] = c;
+		}
+	}
+
+	storage.partial = false;
+	return len;
+}
+
+void storage_discard_cmd()
+{
+	//an error stops the program
+	storage.running = false;
+}
+
+#endif
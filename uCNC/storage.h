@@ -0,0 +1,45 @@
+/*
+	Name: storage.h
+	Description: Program storage for uCNC.
+		Runs gcode programs stored in the mcu storage device (started with the $F command).
+		While a program is running the parser reads the commands from the storage instead of the serial RX buffer.
+
+	Copyright: Copyright (c) João Martins
+	Author: João Martins
+	Date: 19/10/2026
+
+	uCNC is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version. Please see <http://www.gnu.org/licenses/>
+
+	uCNC is distributed WITHOUT ANY WARRANTY;
+	Also without the implied warranty of	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+	See the	GNU General Public License for more details.
+*/
+
+#ifndef STORAGE_H
+#define STORAGE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "config.h"
+
+#ifdef ENABLE_PROGRAM_STORAGE
+//starts running the stored program (returns false if there is no program available)
+bool storage_open();
+//stops running the stored program
+void storage_close();
+bool storage_is_running();
+//loads the next block of the program to the free buffer (called from the main loop)
+void storage_prefetch();
+
+//command stream (same behavior as the serial RX buffer functions)
+bool storage_is_empty();
+unsigned char storage_getc();
+unsigned char storage_peek();
+uint8_t storage_get_frame(uint8_t* buffer, uint8_t size);
+void storage_discard_cmd();
+#endif
+
+#endif